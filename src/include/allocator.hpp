@@ -0,0 +1,368 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_ALLOCATOR_HPP
+#define GUARD_FIN_ALLOCATOR_HPP
+
+#include <hip/hip_runtime_api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fin {
+
+// Source of the memory for buffers, so that the code managing buffers can
+// work with device memory as well as with host memory
+class Allocator
+{
+    public:
+    virtual ~Allocator() = default;
+    virtual void* Allocate(size_t bytes) = 0;
+    virtual void Free(void* ptr)         = 0;
+    // The copies return a status, zero on success
+    virtual int CopyToDevice(void* dst, const void* src, size_t bytes)   = 0;
+    virtual int CopyFromDevice(void* dst, const void* src, size_t bytes) = 0;
+    virtual int Memset(void* dst, int value, size_t bytes)               = 0;
+    // the memory is on the host, no device is involved
+    virtual bool IsHost() const { return false; }
+};
+
+class HostAllocator : public Allocator
+{
+    public:
+    void* Allocate(size_t bytes) override
+    {
+        // 64 byte aligned, like the device allocations are at least
+        void* ptr = std::aligned_alloc(64, (std::max<size_t>(bytes, 1) + 63) / 64 * 64);
+        if(ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+    void Free(void* ptr) override { std::free(ptr); }
+    int CopyToDevice(void* dst, const void* src, size_t bytes) override
+    {
+        std::memcpy(dst, src, bytes);
+        return 0;
+    }
+    int CopyFromDevice(void* dst, const void* src, size_t bytes) override
+    {
+        std::memcpy(dst, src, bytes);
+        return 0;
+    }
+    int Memset(void* dst, int value, size_t bytes) override
+    {
+        std::memset(dst, value, bytes);
+        return 0;
+    }
+    bool IsHost() const override { return true; }
+};
+
+class HipAllocator : public Allocator
+{
+    public:
+    void* Allocate(size_t bytes) override
+    {
+        void* ptr         = nullptr;
+        const auto status = hipMalloc(&ptr, bytes);
+        if(status != hipSuccess || (ptr == nullptr && bytes > 0))
+            throw std::runtime_error("Unable to allocate GPU memory");
+        return ptr;
+    }
+    void Free(void* ptr) override { std::ignore = hipFree(ptr); }
+    int CopyToDevice(void* dst, const void* src, size_t bytes) override
+    {
+        return static_cast<int>(hipMemcpy(dst, src, bytes, hipMemcpyHostToDevice));
+    }
+    int CopyFromDevice(void* dst, const void* src, size_t bytes) override
+    {
+        const auto status = hipDeviceSynchronize();
+        if(status != hipSuccess)
+            throw std::runtime_error("Error while calling hipDeviceSynchronize()");
+        return static_cast<int>(hipMemcpy(dst, src, bytes, hipMemcpyDeviceToHost));
+    }
+    int Memset(void* dst, int value, size_t bytes) override
+    {
+        return static_cast<int>(hipMemset(dst, value, bytes));
+    }
+};
+
+// The allocator of the device buffers. Replacing it with a host allocator,
+// before any buffer is allocated, lets the buffer handling run on machines
+// without a GPU.
+inline std::shared_ptr<Allocator>& DeviceAllocator()
+{
+    static std::shared_ptr<Allocator> allocator = std::make_shared<HipAllocator>();
+    return allocator;
+}
+
+// A single buffer that is reused for the workspace of every solver. It only
+// grows, by at least doubling, so that a sequence of increasing requests
+// costs a logarithmic number of allocations.
+class WorkspacePool
+{
+    public:
+    explicit WorkspacePool(std::shared_ptr<Allocator> _allocator)
+        : allocator(std::move(_allocator))
+    {
+    }
+    WorkspacePool(const WorkspacePool&) = delete;
+    WorkspacePool& operator=(const WorkspacePool&) = delete;
+    ~WorkspacePool() { Release(); }
+
+    // Makes sure the buffer holds at least the given number of bytes
+    void* Reserve(size_t bytes)
+    {
+        if(bytes <= capacity)
+            return ptr;
+        const size_t grown = std::max(bytes, 2 * capacity);
+        // the old buffer is released first to keep the peak memory low
+        Release();
+        try
+        {
+            ptr      = allocator->Allocate(grown);
+            capacity = grown;
+        }
+        catch(const std::exception&)
+        {
+            // no room to grow, the exact size may still fit
+            if(grown == bytes)
+                throw;
+            ptr      = allocator->Allocate(bytes);
+            capacity = bytes;
+        }
+        num_allocations++;
+        return ptr;
+    }
+
+    void Release()
+    {
+        if(ptr != nullptr)
+            allocator->Free(ptr);
+        ptr      = nullptr;
+        capacity = 0;
+    }
+
+    void* Data() const { return ptr; }
+    size_t Size() const { return capacity; }
+    size_t NumAllocations() const { return num_allocations; }
+
+    private:
+    std::shared_ptr<Allocator> allocator;
+    void* ptr              = nullptr;
+    size_t capacity        = 0;
+    size_t num_allocations = 0;
+};
+
+// Keeps released buffers for reuse, keyed by their size in bytes. Jobs
+// that follow each other with the same tensor shapes then get their
+// buffers without going to the allocator. At most max_cached bytes are
+// kept, the buffers released first are freed first. With a max_cached of
+// zero every buffer is freed as soon as it is released. Thread safe.
+class BufferArena
+{
+    public:
+    BufferArena(std::shared_ptr<Allocator> _allocator, size_t _max_cached)
+        : allocator(std::move(_allocator)), max_cached(_max_cached)
+    {
+    }
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+    ~BufferArena() { Trim(0); }
+
+    void* Acquire(size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            // the most recently released buffer of the size is still hot
+            for(auto it = cached.rbegin(); it != cached.rend(); ++it)
+            {
+                if(it->first != bytes)
+                    continue;
+                void* ptr = it->second;
+                cached.erase(std::next(it).base());
+                cached_bytes -= bytes;
+                return ptr;
+            }
+            num_allocations++;
+        }
+        try
+        {
+            return allocator->Allocate(bytes);
+        }
+        catch(const std::exception&)
+        {
+            // the cached buffers may be what is in the way
+            Trim(0);
+            return allocator->Allocate(bytes);
+        }
+    }
+
+    void Release(void* ptr, size_t bytes)
+    {
+        if(ptr == nullptr)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cached.emplace_back(bytes, ptr);
+            cached_bytes += bytes;
+        }
+        Trim(max_cached);
+    }
+
+    // Frees cached buffers, oldest first, until at most max_bytes are cached
+    void Trim(size_t max_bytes)
+    {
+        std::vector<std::pair<size_t, void*>> to_free;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            while(cached_bytes > max_bytes && !cached.empty())
+            {
+                to_free.push_back(cached.front());
+                cached_bytes -= cached.front().first;
+                cached.pop_front();
+            }
+        }
+        for(const auto& buffer : to_free)
+            allocator->Free(buffer.second);
+    }
+
+    // Changes the cap, cached buffers over the new cap are freed
+    void SetMaxCached(size_t bytes)
+    {
+        max_cached = bytes;
+        Trim(max_cached);
+    }
+
+    const std::shared_ptr<Allocator>& GetAllocator() const { return allocator; }
+    size_t MaxCached() const { return max_cached; }
+    size_t CachedBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return cached_bytes;
+    }
+    size_t NumAllocations() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return num_allocations;
+    }
+
+    private:
+    std::shared_ptr<Allocator> allocator;
+    std::atomic<size_t> max_cached;
+    mutable std::mutex mtx;
+    std::list<std::pair<size_t, void*>> cached;
+    size_t cached_bytes    = 0;
+    size_t num_allocations = 0;
+};
+
+// The arena of the tensor buffers on the device. It follows DeviceAllocator,
+// buffers from an arena that was replaced go back to it and are freed with
+// it once the last of them is released. Nothing is cached unless the cap is
+// raised with SetMaxCached, which carries over to a replacing arena.
+inline std::shared_ptr<BufferArena> DeviceArena()
+{
+    static std::mutex mtx;
+    static std::shared_ptr<BufferArena> arena;
+    std::lock_guard<std::mutex> lock(mtx);
+    if(arena == nullptr || arena->GetAllocator() != DeviceAllocator())
+    {
+        const size_t max_cached = arena == nullptr ? 0 : arena->MaxCached();
+        arena = std::make_shared<BufferArena>(DeviceAllocator(), max_cached);
+    }
+    return arena;
+}
+
+// The arena of the host copies of tensors, nothing is cached unless the cap
+// is raised with SetMaxCached
+inline std::shared_ptr<BufferArena> HostArena()
+{
+    static const auto arena = std::make_shared<BufferArena>(std::make_shared<HostAllocator>(), 0);
+    return arena;
+}
+
+// std::allocator replacement drawing from the host arena. Elements are
+// default initialized, so resizing a buffer that is about to be overwritten
+// does not clear it first.
+template <typename T>
+class HostArenaAllocator
+{
+    public:
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    HostArenaAllocator() : arena(HostArena()) {}
+    template <typename U>
+    HostArenaAllocator(const HostArenaAllocator<U>& other) : arena(other.GetArena())
+    {
+    }
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->Acquire(n * sizeof(T))); }
+    void deallocate(T* ptr, size_t n) { arena->Release(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+    {
+        ::new(static_cast<void*>(ptr)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args)
+    {
+        ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+
+    const std::shared_ptr<BufferArena>& GetArena() const { return arena; }
+
+    template <typename U>
+    bool operator==(const HostArenaAllocator<U>& other) const
+    {
+        return arena == other.GetArena();
+    }
+    template <typename U>
+    bool operator!=(const HostArenaAllocator<U>& other) const
+    {
+        return !(*this == other);
+    }
+
+    private:
+    // keeps the arena alive for as long as buffers may be returned to it
+    std::shared_ptr<BufferArena> arena;
+};
+
+} // namespace fin
+
+#endif // GUARD_FIN_ALLOCATOR_HPP
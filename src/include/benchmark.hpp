@@ -0,0 +1,213 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_BENCHMARK_HPP
+#define GUARD_FIN_BENCHMARK_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+// How often a kernel is timed. By default it is run a fixed number of times,
+// in adaptive mode the runs stop as soon as the timings are stable: the
+// coefficient of variation or the relative half width of the 95% confidence
+// interval of the mean is below its target, within the iteration bounds.
+struct BenchmarkConfig
+{
+    size_t warmup    = 1;
+    size_t min_iters = 4;
+    size_t max_iters = 4;
+    bool adaptive    = false;
+    // zero disables the criterion
+    double target_cv = 0.0;
+    double target_ci = 0.0;
+    // invocations timed together, the sample is their average
+    size_t batch = 1;
+    // "kernel" sums the kernel times recorded by the handle, "events" times a
+    // whole batch on the stream with a single sync, "host" takes the wall time
+    // on the host
+    std::string timer = "kernel";
+
+    // Read from the "benchmark" object of a job, the settings it does not
+    // give are taken from the base config
+    static BenchmarkConfig FromJson(const json& j, BenchmarkConfig config)
+    {
+        config.adaptive = j.value("adaptive", config.adaptive);
+        if(config.adaptive)
+        {
+            config.min_iters = 5;
+            config.max_iters = 100;
+            config.target_cv = 0.02;
+        }
+        config.warmup    = j.value("warmup", config.warmup);
+        config.min_iters = std::max<size_t>(j.value("min_iters", config.min_iters), 1);
+        config.max_iters = std::max(j.value("max_iters", config.max_iters), config.min_iters);
+        config.target_cv = j.value("target_cv", config.target_cv);
+        config.target_ci = j.value("target_ci", config.target_ci);
+        config.batch     = std::max<size_t>(j.value("batch", config.batch), 1);
+        config.timer     = j.value("timer", config.timer);
+        if(config.timer != "kernel" && config.timer != "events" && config.timer != "host")
+            throw std::runtime_error("Invalid benchmark timer: " + config.timer);
+        return config;
+    }
+    static BenchmarkConfig FromJson(const json& j) { return FromJson(j, BenchmarkConfig{}); }
+};
+
+struct BenchmarkStats
+{
+    size_t iterations = 0;
+    float min         = -1;
+    float median      = -1;
+    float mean        = -1;
+    float stddev      = 0;
+    float p90         = -1;
+
+    json ToJson() const
+    {
+        json j;
+        j["iterations"] = iterations;
+        j["min"]        = min;
+        j["median"]     = median;
+        j["mean"]       = mean;
+        j["stddev"]     = stddev;
+        j["p90"]        = p90;
+        return j;
+    }
+};
+
+inline BenchmarkStats ComputeBenchmarkStats(std::vector<float> times)
+{
+    BenchmarkStats stats;
+    if(times.empty())
+        return stats;
+    std::sort(times.begin(), times.end());
+    const auto n     = times.size();
+    stats.iterations = n;
+    stats.min        = times.front();
+    // lower median, as reported before the statistics were added
+    stats.median = times[(n - 1) / 2];
+    // nearest rank
+    stats.p90 = times[static_cast<size_t>(std::ceil(0.9 * static_cast<double>(n))) - 1];
+
+    const double sum  = std::accumulate(times.begin(), times.end(), 0.0);
+    const double mean = sum / static_cast<double>(n);
+    double sq_sum     = 0.0;
+    for(const auto t : times)
+        sq_sum += (t - mean) * (t - mean);
+    stats.mean   = static_cast<float>(mean);
+    stats.stddev = n > 1 ? static_cast<float>(std::sqrt(sq_sum / static_cast<double>(n - 1))) : 0;
+    return stats;
+}
+
+// Whether the timings taken so far satisfy one of the stopping criteria
+inline bool IsBenchmarkStable(const BenchmarkStats& stats, const BenchmarkConfig& config)
+{
+    if(stats.iterations < 2 || stats.mean <= 0)
+        return false;
+    const double cv = stats.stddev / stats.mean;
+    if(config.target_cv > 0 && cv <= config.target_cv)
+        return true;
+    const double ci = 1.96 * cv / std::sqrt(static_cast<double>(stats.iterations));
+    return config.target_ci > 0 && ci <= config.target_ci;
+}
+
+// Times a kernel with the given timing source, sample() runs the kernel once
+// and returns its time
+template <typename Sample>
+BenchmarkStats RunBenchmark(const BenchmarkConfig& config, Sample&& sample)
+{
+    for(size_t idx = 0; idx < config.warmup; idx++)
+        sample();
+    std::vector<float> times;
+    times.reserve(config.max_iters);
+    BenchmarkStats stats;
+    while(times.size() < config.max_iters)
+    {
+        times.push_back(sample());
+        if(!config.adaptive || times.size() < config.min_iters)
+            continue;
+        stats = ComputeBenchmarkStats(times);
+        if(IsBenchmarkStable(stats, config))
+            break;
+    }
+    stats = ComputeBenchmarkStats(times);
+    std::cerr << "kernel_time median : " << stats.median << ", mean : " << stats.mean
+              << ", stddev : " << stats.stddev << ", runs : " << stats.iterations << std::endl;
+    return stats;
+}
+
+// Wall time on the host in ms, for invokers that run on the host
+class HostTimer
+{
+    public:
+    void Start() { start = std::chrono::steady_clock::now(); }
+    void Lap() {}
+    float Stop() const
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    }
+
+    private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Times invoke(params) with any timer that provides Start(), Lap(), called
+// after every invocation, and Stop(), which returns the time of all the
+// invocations since Start(). Every sample is the average of a batch.
+template <typename Invoke, typename Params, typename Timer>
+BenchmarkStats BenchmarkInvocations(const BenchmarkConfig& config,
+                                    Invoke&& invoke,
+                                    const Params& params,
+                                    Timer& timer)
+{
+    const size_t batch = std::max<size_t>(config.batch, 1);
+    return RunBenchmark(config, [&]() {
+        timer.Start();
+        for(size_t idx = 0; idx < batch; idx++)
+        {
+            invoke(params);
+            timer.Lap();
+        }
+        return timer.Stop() / static_cast<float>(batch);
+    });
+}
+
+} // namespace fin
+
+#endif // GUARD_FIN_BENCHMARK_HPP
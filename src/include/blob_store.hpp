@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_BLOB_STORE_HPP
+#define GUARD_FIN_BLOB_STORE_HPP
+
+#include "base64.hpp"
+
+#include <nlohmann/json.hpp>
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+inline boost::filesystem::path BlobPath(const boost::filesystem::path& dir,
+                                        const std::string& md5_sum)
+{
+    return dir / (md5_sum + ".bz2");
+}
+
+// Directory of compressed code objects, one file per md5 of the code object.
+// A blob is only written once, concurrent writers of the same blob write to
+// temporary files and the last rename wins with identical content.
+class BlobStore
+{
+    public:
+    explicit BlobStore(const boost::filesystem::path& _dir) : dir(_dir)
+    {
+        boost::filesystem::create_directories(dir);
+    }
+
+    // Returns the path of the stored blob
+    std::string Put(const std::string& md5_sum, const std::string& blob) const
+    {
+        const auto path = BlobPath(dir, md5_sum);
+        if(boost::filesystem::exists(path))
+            return path.string();
+        const auto tmp_path = dir / boost::filesystem::unique_path(md5_sum + ".%%%%-%%%%.tmp");
+        {
+            std::ofstream ofs(tmp_path.string(), std::ios::binary);
+            ofs.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+            if(!ofs)
+                throw std::runtime_error("Unable to write blob: " + tmp_path.string());
+        }
+        boost::filesystem::rename(tmp_path, path);
+        return path.string();
+    }
+
+    static std::string Read(const boost::filesystem::path& path)
+    {
+        std::ifstream ifs(path.string(), std::ios::binary);
+        if(!ifs)
+            throw std::runtime_error("Unable to read blob: " + path.string());
+        return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    }
+
+    private:
+    boost::filesystem::path dir;
+};
+
+// The compressed code object of a kernel object. It comes from the inline
+// blob, from the "kernel_blobs" table of the job, or from the blob store,
+// in that order.
+inline std::string LoadCompressedKernel(const json& kernel_obj, const json& job)
+{
+    if(kernel_obj.contains("blob"))
+        return base64_decode(kernel_obj["blob"].get<std::string>());
+    const std::string md5_sum = kernel_obj["md5_sum"];
+    if(job.contains("kernel_blobs") && job["kernel_blobs"].contains(md5_sum))
+        return base64_decode(job["kernel_blobs"][md5_sum]["blob"].get<std::string>());
+    if(kernel_obj.contains("blob_path"))
+    {
+        const boost::filesystem::path path = kernel_obj["blob_path"].get<std::string>();
+        if(boost::filesystem::exists(path))
+            return BlobStore::Read(path);
+    }
+    // the store may have been moved since the kernels were compiled
+    if(job.contains("blob_store"))
+    {
+        const auto path = BlobPath(job["blob_store"].get<std::string>(), md5_sum);
+        if(boost::filesystem::exists(path))
+            return BlobStore::Read(path);
+    }
+    throw std::runtime_error("Missing blob for kernel: " + md5_sum);
+}
+
+} // namespace fin
+
+#endif // GUARD_FIN_BLOB_STORE_HPP
@@ -55,6 +55,7 @@ class BNFin : public BaseFin
     BNFin() : BaseFin() {}
     BNFin(json _job) : BaseFin(), job(_job)
     {
+        InitJobOptions(job);
         if(job.contains("config"))
             PrepBatchNorm();
     }
@@ -424,8 +425,6 @@ int BNFin<Tgpu, Tref>::MIOpenFindCompile()
 
     for(const auto& sln : GetBNSolutions(ctx))
     {
-        // remove the user db files
-        boost::filesystem::remove_all(miopen::GetCachePath(false));
         json res_item;
         res_item["solver_name"] = sln.solver_id;
         res_item["algorithm"]   = GetAlgorithm();
@@ -434,50 +433,13 @@ int BNFin<Tgpu, Tref>::MIOpenFindCompile()
         std::vector<miopen::solver::KernelInfo> kernels;
         for(auto&& kernel : sln.construction_params) // cppcheck-suppress useStlAlgorithm
             kernels.push_back(kernel);
-        std::ignore      = miopen::solver::PrecompileKernels(handle, kernels);
-        json kernel_list = json::array();
-        for(const auto& k : kernels)
-        {
-            json kernel;
-            auto comp_opts   = k.comp_options;
-            auto p           = handle.LoadProgram(k.kernel_file, comp_opts, false, "");
-            const auto hsaco = p.IsCodeObjectInMemory()
-                                   ? p.GetCodeObjectBlob()
-                                   : miopen::LoadFile(p.GetCodeObjectPathname().string());
-            if(hsaco.empty())
-            {
-                std::cerr << "Got empty code object" << std::endl;
-                throw std::runtime_error("Got empty code object");
-            }
-            // Compress the blob
-            auto md5_sum             = miopen::md5(hsaco);
-            auto size                = hsaco.size();
-            bool success             = false;
-            auto compressed_hsaco    = miopen::compress(hsaco, &success);
-            const auto encoded_hsaco = base64_encode(compressed_hsaco);
-            kernel["kernel_file"]    = k.kernel_file;
-            kernel["comp_options"]   = k.comp_options;
-            if(success)
-            {
-                kernel["uncompressed_size"] = size;
-                kernel["md5_sum"]           = md5_sum;
-                kernel["blob"]              = encoded_hsaco;
-            }
-            else
-            {
-                kernel["md5_sum"]           = "Failed to compress kernel";
-                kernel["uncompressed_size"] = 0;
-                kernel["blob"]              = "";
-            }
-            kernel_list.push_back(kernel);
-            std::cerr << "Successfully added new kernel" << std::endl;
-        }
-        res_item["kernel_objects"] = kernel_list;
+        res_item["kernel_objects"] = PrecompileJsonKernelList(handle, kernels, 1);
         res_item["reason"]         = "Success";
         res_item["find_compiled"]  = true;
         find_result.push_back(res_item);
     }
     output["miopen_find_compile_result"] = find_result;
+    AddKernelBlobs(find_result);
     return 1;
 }
 
@@ -27,10 +27,14 @@
 #ifndef GUARD_CONV_FIN_HPP
 #define GUARD_CONV_FIN_HPP
 #include "base64.hpp"
+#include "cpu_conv.hpp"
 #include "error.hpp"
 #include "fin.hpp"
+#include "kernel_loader.hpp"
+#include "layout_transform.hpp"
 #include "random.hpp"
 #include "tensor.hpp"
+#include "thread_pool.hpp"
 
 #include <miopen/algorithm.hpp>
 #include <miopen/execution_context.hpp>
@@ -57,11 +61,14 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <float.h>
+#include <functional>
 #include <fstream>
 #include <limits>
+#include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <numeric>
@@ -83,10 +90,22 @@ class ConvFin : public BaseFin
     ConvFin() : BaseFin() {}
     ConvFin(json _job) : BaseFin(), job(_job)
     {
+        InitJobOptions(job);
         if(job.contains("config"))
             PrepConvolution();
     }
 
+    // Filled inputs outlive the job when "reuse_filled_data" is set
+    ~ConvFin() override
+    {
+        if(!job.is_object() || !job.value("reuse_filled_data", false))
+            return;
+        inputTensor.RetainFilledData();
+        outputTensor.RetainFilledData();
+        weightTensor.RetainFilledData();
+        biasTensor.RetainFilledData();
+    }
+
     void PrepConvolution()
     {
         BaseFin::VerifyDevProps(job["arch"], job["num_cu"]);
@@ -108,7 +127,18 @@ class ConvFin : public BaseFin
     int SetConvDescriptor();
 
     miopen::ProblemDescription GetCmdConvProblem(json _command);
-    miopen::ProblemDescription BuildConvProblem(miopen::SQLite& sql, std::string config_id);
+    miopen::ProblemDescription SetupNoGpuProblem(miopen::Handle& handle,
+                                                 miopen::ConvolutionContext& ctx,
+                                                 const std::string& step_name);
+    // Columns of the perf db config table read by ReadConvConfig
+    static std::string ConvConfigColumns();
+    // Reads the ConvConfigColumns of a row starting at column first into a
+    // command, with the data type of the config
+    static json
+    ReadConvConfig(miopen::SQLite::Statement& stmt, int first, const std::string& config_id);
+    // Builds the problem of a command from ReadConvConfig, safe to call from
+    // several threads
+    static miopen::ProblemDescription BuildConvProblem(const json& config_cmd);
 
     std::vector<size_t> GetOutputTensorLengths() const;
     miopenDataType_t GetOutputType() const
@@ -116,6 +146,8 @@ class ConvFin : public BaseFin
         return (data_type == miopenInt8) ? miopenFloat : data_type;
     }
     miopen::conv::Direction GetDirection() const;
+    template <typename F>
+    void VisitInvokeParams(F&& fn);
 
     int ProcessStep(const std::string& step_name) override;
 
@@ -125,6 +157,7 @@ class ConvFin : public BaseFin
     int FillBuffers();
     int CopyToDevice();
     int CopyFromDevice();
+    int VerifyOutput();
     int RunGPU();
     int TestApplicability();
 
@@ -134,7 +167,7 @@ class ConvFin : public BaseFin
         const miopen::ProblemDescription& problem,
         const std::map<std::string, std::unordered_map<std::string, std::string>>& perf_ids,
         std::vector<std::map<std::string, std::string>>& err_list,
-        std::vector<std::string>& pdb_id);
+        std::vector<std::string>& pdb_id) const;
 
     int TestPerfDbValid();
     int GetandSetData();
@@ -144,10 +177,21 @@ class ConvFin : public BaseFin
     // function used to Search the Precompiled Kernels
     int SearchPreCompiledKernels();
     int MIOpenPerfCompile();
+    int MIOpenPerfCfgCount();
     int MIOpenPerfEval();
+    bool EvalPerfCfg(const miopen::solver::AnySolver& s,
+                     const miopen::ConvolutionContext& ctx,
+                     const miopen::ProblemDescription& problem,
+                     miopen::PerformanceDb& db,
+                     const std::string& perf_cfg,
+                     const json& input_kernels,
+                     json& res_item);
 
     // Utility functions
     bool IsInputTensorTransform() const;
+    std::vector<miopen::solver::Id> GetJobSolvers() const;
+    std::pair<size_t, size_t> GetPerfCfgSlice(const std::string& solver_name, size_t total) const;
+    std::vector<std::string> GetJobPerfCfgs(const std::string& solver_name) const;
     json command;
     json job;
 
@@ -176,17 +220,71 @@ miopen::conv::Direction ConvFin<Tgpu, Tref>::GetDirection() const
                             : miopen::conv::Direction::BackwardWeights);
 }
 
+// Calls fn with the invoke params of the job direction. DataInvokeParams
+// switches the tensor order with the direction and has neither a copy nor a
+// default constructor, so the params only live for the duration of the call.
 template <typename Tgpu, typename Tref>
-int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
+template <typename F>
+void ConvFin<Tgpu, Tref>::VisitInvokeParams(F&& fn)
+{
+    const auto conv_dir = GetDirection();
+    const auto& ws      = DeviceWorkspace();
+    if(conv_dir == miopen::conv::Direction::Forward)
+    {
+        fn(miopen::conv::DataInvokeParams{{inputTensor.desc,
+                                           inputTensor.gpuData.buf.get(),
+                                           weightTensor.desc,
+                                           weightTensor.gpuData.buf.get(),
+                                           outputTensor.desc,
+                                           outputTensor.gpuData.buf.get()},
+                                          ws.Data(),
+                                          ws.Size(),
+                                          convDesc.attribute.gfx90aFp16alt.GetFwd()});
+    }
+    else if(conv_dir == miopen::conv::Direction::BackwardData)
+    {
+        fn(miopen::conv::DataInvokeParams{{outputTensor.desc,
+                                           outputTensor.gpuData.buf.get(),
+                                           weightTensor.desc,
+                                           weightTensor.gpuData.buf.get(),
+                                           inputTensor.desc,
+                                           inputTensor.gpuData.buf.get()},
+                                          ws.Data(),
+                                          ws.Size(),
+                                          convDesc.attribute.gfx90aFp16alt.GetBwd()});
+    }
+    else if(conv_dir == miopen::conv::Direction::BackwardWeights)
+    {
+        fn(miopen::conv::WrWInvokeParams{{outputTensor.desc,
+                                          outputTensor.gpuData.buf.get(),
+                                          inputTensor.desc,
+                                          inputTensor.gpuData.buf.get(),
+                                          weightTensor.desc,
+                                          weightTensor.gpuData.buf.get()},
+                                         ws.Data(),
+                                         ws.Size(),
+                                         convDesc.attribute.gfx90aFp16alt.GetWrW()});
+    }
+    else
+    {
+        throw std::runtime_error("Invalid Direction: " +
+                                 std::to_string(static_cast<int>(conv_dir)));
+    }
+}
+
+// Sets the tensors up from the command and returns the problem of the job,
+// with ctx running on handle as a NOGPU handle of the job arch
+template <typename Tgpu, typename Tref>
+miopen::ProblemDescription ConvFin<Tgpu, Tref>::SetupNoGpuProblem(
+    miopen::Handle& handle, miopen::ConvolutionContext& ctx, const std::string& step_name)
 {
-#if MIOPEN_ALLSOLVER
-    std::cerr << "MIOpenPerfCompile" << std::endl;
-    std::cerr << "Processing command: " << command << std::endl;
 #if MIOPEN_MODE_NOGPU
+    std::ignore = step_name;
     GetandSetData();
+    BaseFin::InitNoGpuHandle(handle, job["arch"], job["num_cu"]);
 #else
-    throw std::runtime_error(
-        "Unable to perform MIOpenPerfCompile MIOpen was not compiled using HIPNOGPU backend");
+    throw std::runtime_error("Unable to perform " + step_name +
+                             " MIOpen was not compiled using HIPNOGPU backend");
 #endif
     const auto conv_dir = GetDirection();
     const auto conv_problem =
@@ -196,19 +294,24 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
             : miopen::conv::ProblemDescription(
                   outputTensor.desc, weightTensor.desc, inputTensor.desc, convDesc, conv_dir);
     const miopen::ProblemDescription problem(conv_problem);
-    GetHandle().EnableProfiling(true);
+    ctx.SetStream(&handle);
+    problem.conv_problem.SetupFloats(ctx);
+    return problem;
+}
+
+template <typename Tgpu, typename Tref>
+int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
+{
+#if MIOPEN_ALLSOLVER
+    std::cerr << "MIOpenPerfCompile" << std::endl;
+    std::cerr << "Processing command: " << command << std::endl;
     // cppcheck-suppress unreadVariable
     auto ctx = miopen::ConvolutionContext{};
     // cppcheck-suppress unreadVariable
-    auto handle = miopen::Handle{};
-#if MIOPEN_MODE_NOGPU
-    BaseFin::InitNoGpuHandle(handle, job["arch"], job["num_cu"]);
-#else
-    throw std::runtime_error("MIOpen needs to be compiled with the NOGPU backend "
-                             "for MIOpenPerfCompile");
-#endif
-    ctx.SetStream(&handle);
-    problem.conv_problem.SetupFloats(ctx);
+    auto handle         = miopen::Handle{};
+    const auto problem  = SetupNoGpuProblem(handle, ctx, "MIOpenPerfCompile");
+    const auto conv_dir = GetDirection();
+    GetHandle().EnableProfiling(true);
 
     const auto network_config   = problem.BuildConfKey();
     const bool is_winograd_only = convDesc.IsWinograd3x3SupportedAndFast(ctx, problem);
@@ -226,18 +329,12 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
     std::cerr << "Job Arch: " << job["arch"] << ": Handle Arch: " << arch << std::endl;
     std::cerr << "Job Num CU: " << job["num_cu"] << ": Handle Num Cu: " << num_cu << std::endl;
 
-    std::vector<miopen::solver::Id> solver_list;
-    if(job.contains("solvers"))
-        for(std::string solver_str : job["solvers"]) // cppcheck-suppress useStlAlgorithm
-            solver_list.push_back(miopen::solver::Id(solver_str));
-    else
-        solver_list = miopen::solver::GetSolversByPrimitive(miopen::solver::Primitive::Convolution);
+    const auto solver_list = GetJobSolvers();
 
+    const size_t num_threads = GetNumThreads(job);
     for(const auto& solver_id : solver_list)
     {
         json res_item;
-        // remove the user db files
-        boost::filesystem::remove_all(miopen::GetCachePath(false));
         auto process_solver = [&]() -> bool {
             std::cerr << "Processing Solver: " << solver_id.ToString() << std::endl;
             const auto& s           = solver_id.GetSolver();
@@ -269,7 +366,30 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
                 res_item["tunable"] = false;
 
             std::vector<miopen::solver::ConvSolution> all_solutions;
-            if(s.IsTunable())
+            const auto perf_cfgs = GetJobPerfCfgs(solver_id.ToString());
+            if(!perf_cfgs.empty())
+            {
+                try
+                {
+                    for(const auto& perf_cfg : perf_cfgs)
+                    {
+                        if(!s.TestPerfCfgParams(ctx, problem, perf_cfg))
+                        {
+                            res_item["reason"] = "Invalid params: " + perf_cfg;
+                            std::cerr << "Invalid params: " << perf_cfg << std::endl;
+                            return false;
+                        }
+                        all_solutions.push_back(s.FindSolution(ctx, problem, db, {}, perf_cfg));
+                    }
+                }
+                catch(const std::exception& e)
+                {
+                    res_item["reason"] = std::string("No solutions: ") + e.what();
+                    std::cerr << "Error getting solutions: " << e.what() << std::endl;
+                    return false;
+                }
+            }
+            else if(s.IsTunable())
             {
                 try
                 {
@@ -285,17 +405,39 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
             else
                 all_solutions.push_back(s.FindSolution(ctx, problem, db, {}));
 
+            // only the requested part of the perf config space is compiled
+            const auto slice = GetPerfCfgSlice(solver_id.ToString(), all_solutions.size());
+
+            res_item["perf_cfg_total"] = all_solutions.size();
+            res_item["perf_cfg_start"] = slice.first;
+            res_item["perf_cfg_count"] = slice.second;
+            if(slice.second == 0)
+            {
+                res_item["reason"] = "Empty perf config slice";
+                std::cerr << "No perf configs to compile for: " << solver_id.ToString()
+                          << std::endl;
+                return false;
+            }
+
             // PrecompileKernels call saves to binary_cache,
             // this needs to be escaped if KERN_CACHE is not on.
+            const auto compiled = boost::adaptors::slice(
+                all_solutions, slice.first, slice.first + slice.second);
             std::vector<miopen::solver::KernelInfo> kernels;
-            for(const auto& current_solution : all_solutions)
+            for(const auto& current_solution : compiled)
                 for(auto&& kernel :
                     current_solution.construction_params) // cppcheck-suppress useStlAlgorithm
                     kernels.push_back(kernel);
-            std::ignore = miopen::solver::PrecompileKernels(handle, kernels);
 
+            // the perf eval times exactly the compiled configs, without a search
+            if(!perf_cfgs.empty())
+                res_item["params"] =
+                    std::vector<std::string>(perf_cfgs.begin() + slice.first,
+                                             perf_cfgs.begin() + slice.first + slice.second);
+
+            // packaging of the compiled kernels overlaps with the compilation
             res_item["reason"]         = "Success";
-            res_item["kernel_objects"] = BuildJsonKernelList(handle, kernels);
+            res_item["kernel_objects"] = PrecompileJsonKernelList(handle, kernels, num_threads);
             return true;
         };
 
@@ -305,12 +447,135 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfCompile()
         perf_result.push_back(res_item);
     }
     output["miopen_perf_compile_result"] = perf_result;
+    AddKernelBlobs(perf_result);
 #else
     throw std::runtime_error("Unsupported feature");
 #endif
     return 1;
 }
 
+template <typename Tgpu, typename Tref>
+std::vector<miopen::solver::Id> ConvFin<Tgpu, Tref>::GetJobSolvers() const
+{
+    std::vector<miopen::solver::Id> solver_list;
+    if(job.contains("solvers"))
+        for(std::string solver_str : job["solvers"]) // cppcheck-suppress useStlAlgorithm
+            solver_list.push_back(miopen::solver::Id(solver_str));
+    else
+        solver_list = miopen::solver::GetSolversByPrimitive(miopen::solver::Primitive::Convolution);
+    return solver_list;
+}
+
+// The perf config space of a solver may be split across several jobs with
+// "perf_cfg_slice": {"<solver_name>": {"start": <index>, "count": <configs>}}
+// the whole space is used for solvers which are not listed.
+template <typename Tgpu, typename Tref>
+std::pair<size_t, size_t> ConvFin<Tgpu, Tref>::GetPerfCfgSlice(const std::string& solver_name,
+                                                               size_t total) const
+{
+    size_t start = 0;
+    size_t count = total;
+    if(job.contains("perf_cfg_slice") && job["perf_cfg_slice"].contains(solver_name))
+    {
+        const auto& slice = job["perf_cfg_slice"][solver_name];
+        if(slice.contains("start"))
+            start = slice["start"];
+        if(slice.contains("count"))
+            count = slice["count"];
+    }
+    start = std::min(start, total);
+    count = std::min(count, total - start);
+    return {start, count};
+}
+
+// A perf compile job may list the perf configs to compile for a solver with
+// "perf_cfgs": {"<solver_name>": [<perf config>, ...]}, the perf eval then
+// times exactly those. Solvers which are not listed are searched as usual.
+template <typename Tgpu, typename Tref>
+std::vector<std::string> ConvFin<Tgpu, Tref>::GetJobPerfCfgs(const std::string& solver_name) const
+{
+    if(!job.contains("perf_cfgs") || !job["perf_cfgs"].contains(solver_name))
+        return {};
+    const auto& perf_cfgs = job["perf_cfgs"][solver_name];
+    if(perf_cfgs.is_array())
+        return perf_cfgs.get<std::vector<std::string>>();
+    return {perf_cfgs.get<std::string>()};
+}
+
+// Reports the size of the perf config space of every applicable solver, so
+// that the perf compile of large spaces can be split with perf_cfg_slice
+template <typename Tgpu, typename Tref>
+int ConvFin<Tgpu, Tref>::MIOpenPerfCfgCount()
+{
+    std::cerr << "MIOpenPerfCfgCount" << std::endl;
+    std::cerr << "Processing command: " << command << std::endl;
+    // cppcheck-suppress unreadVariable
+    auto ctx = miopen::ConvolutionContext{};
+    // cppcheck-suppress unreadVariable
+    auto handle         = miopen::Handle{};
+    const auto problem  = SetupNoGpuProblem(handle, ctx, "MIOpenPerfCfgCount");
+    const auto conv_dir = GetDirection();
+
+    std::ostringstream ss;
+    problem.Serialize(ss);
+    output["network_config"] = problem.BuildConfKey();
+    output["db_key"]         = ss.str();
+
+    json count_result;
+    for(const auto& solver_id : GetJobSolvers())
+    {
+        json res_item;
+        auto process_solver = [&]() -> bool {
+            const auto& s           = solver_id.GetSolver();
+            res_item["solver_name"] = solver_id.ToString();
+            res_item["algorithm"]   = solver_id.GetAlgo(conv_dir);
+
+            if(solver_id.ToString() == "ConvBiasActivAsm1x1U" ||
+               solver_id.ToString().find("Fused") != std::string::npos)
+            {
+                res_item["reason"] = "Skip Fused";
+                return false;
+            }
+            if(s.IsEmpty())
+            {
+                res_item["reason"] = "Empty Solver";
+                return false;
+            }
+            if(!s.IsApplicable(ctx, problem))
+            {
+                res_item["reason"] = "Not Applicable";
+                return false;
+            }
+            res_item["tunable"] = s.IsTunable();
+            if(!s.IsTunable())
+            {
+                res_item["perf_cfg_count"] = 1;
+                res_item["reason"]         = "Success";
+                return true;
+            }
+            try
+            {
+                res_item["perf_cfg_count"] = s.GetAllSolutions(ctx, problem).size();
+            }
+            catch(const std::exception& e)
+            {
+                res_item["reason"] = std::string("No solutions: ") + e.what();
+                std::cerr << "Error getting solutions: " << e.what() << std::endl;
+                return false;
+            }
+            res_item["reason"] = "Success";
+            return true;
+        };
+
+        res_item["counted"] = process_solver();
+        std::cerr << solver_id.ToString() << ": " << res_item.value("perf_cfg_count", 0)
+                  << " perf configs" << std::endl;
+        count_result.push_back(res_item);
+    }
+    output["miopen_perf_cfg_count_result"] = count_result;
+    return 1;
+}
+
 template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::MIOpenFindCompile()
 {
@@ -335,8 +600,10 @@ int ConvFin<Tgpu, Tref>::MIOpenFindCompile()
     auto ctx = miopen::ConvolutionContext{};
     // cppcheck-suppress unreadVariable
     auto handle = miopen::Handle{};
+    const std::string job_arch = job["arch"];
+    const unsigned long job_cu = job["num_cu"];
 #if MIOPEN_MODE_NOGPU
-    BaseFin::InitNoGpuHandle(handle, job["arch"], job["num_cu"]);
+    BaseFin::InitNoGpuHandle(handle, job_arch, job_cu);
 #else
     throw std::runtime_error("MIOpen needs to be compiled with the NOGPU backend "
                              "for MIOpenFindCompile");
@@ -352,7 +619,6 @@ int ConvFin<Tgpu, Tref>::MIOpenFindCompile()
     problem.Serialize(ss);
     output["db_key"] = ss.str();
 
-    auto db = GetDb(ctx);
     json find_result;
     const auto& tgt_props  = handle.GetTargetProperties();
     const std::string arch = tgt_props.Name();
@@ -363,81 +629,113 @@ int ConvFin<Tgpu, Tref>::MIOpenFindCompile()
     if(job.contains("dynamic_only"))
         dynamic_only = job["dynamic_only"];
 
-    std::vector<miopen::solver::Id> solver_list;
-    if(job.contains("solvers"))
-        for(std::string solver_str : job["solvers"]) // cppcheck-suppress useStlAlgorithm
-            solver_list.push_back(miopen::solver::Id(solver_str));
-    else
-        solver_list = miopen::solver::GetSolversByPrimitive(miopen::solver::Primitive::Convolution);
-
-    // since applicability has been run, the solver list should come from Tuna
-    for(const auto& solver_id : solver_list)
-    {
-        json res_item;
-        // remove the user db files
-        boost::filesystem::remove_all(miopen::GetCachePath(false));
-        auto process_solver = [&]() -> bool {
-            std::cerr << "Processing Solver: " << solver_id.ToString() << std::endl;
-            const auto& s           = solver_id.GetSolver();
-            const auto algo         = solver_id.GetAlgo(conv_dir);
-            res_item["solver_name"] = solver_id.ToString();
-            res_item["algorithm"]   = algo;
-
-            if(solver_id.ToString() == "ConvBiasActivAsm1x1U" ||
-               solver_id.ToString().find("Fused") != std::string::npos)
-            {
-                res_item["reason"] = "Skip Fused";
-                std::cerr << "Skipping fused solvers" << std::endl;
-                return false;
-            }
-            if(s.IsEmpty())
-            {
-                res_item["reason"] = "Empty Solver";
-                std::cerr << "Skipping invalid solver: " << solver_id.ToString() << std::endl;
-                return false;
-            }
-            if(!s.IsApplicable(ctx, problem))
-            {
-                res_item["reason"] = "Not Applicable";
-                std::cerr << "Skipping inapplicable solver: " << solver_id.ToString() << std::endl;
-                return false;
-            }
-            if(dynamic_only && !s.IsDynamic())
-            {
-                res_item["reason"] = "Not Dynamic";
-                std::cerr << "Skipping static solver: " << solver_id.ToString() << std::endl;
-                return false;
-            }
+    const auto solver_list = GetJobSolvers();
+
+    const auto process_solver = [&](const miopen::solver::Id& solver_id,
+                                    const miopen::Handle& solver_handle,
+                                    const miopen::ConvolutionContext& solver_ctx,
+                                    miopen::PerformanceDb& db,
+                                    json& res_item) -> bool {
+        std::cerr << "Processing Solver: " << solver_id.ToString() << std::endl;
+        const auto& s           = solver_id.GetSolver();
+        const auto algo         = solver_id.GetAlgo(conv_dir);
+        res_item["solver_name"] = solver_id.ToString();
+        res_item["algorithm"]   = algo;
+
+        if(solver_id.ToString() == "ConvBiasActivAsm1x1U" ||
+           solver_id.ToString().find("Fused") != std::string::npos)
+        {
+            res_item["reason"] = "Skip Fused";
+            std::cerr << "Skipping fused solvers" << std::endl;
+            return false;
+        }
+        if(s.IsEmpty())
+        {
+            res_item["reason"] = "Empty Solver";
+            std::cerr << "Skipping invalid solver: " << solver_id.ToString() << std::endl;
+            return false;
+        }
+        if(!s.IsApplicable(solver_ctx, problem))
+        {
+            res_item["reason"] = "Not Applicable";
+            std::cerr << "Skipping inapplicable solver: " << solver_id.ToString() << std::endl;
+            return false;
+        }
+        if(dynamic_only && !s.IsDynamic())
+        {
+            res_item["reason"] = "Not Dynamic";
+            std::cerr << "Skipping static solver: " << solver_id.ToString() << std::endl;
+            return false;
+        }
 
-            res_item["params"]  = s.GetPerfCfgParams(ctx, problem, db);
-            res_item["tunable"] = false;
-            if(s.IsTunable())
-                res_item["tunable"] = true;
+        res_item["params"]  = s.GetPerfCfgParams(solver_ctx, problem, db);
+        res_item["tunable"] = false;
+        if(s.IsTunable())
+            res_item["tunable"] = true;
 
-            miopen::solver::ConvSolution solution;
-            try
-            {
-                solution = s.FindSolution(ctx, problem, db, {}); // auto tune is not expected here
-            }
-            catch(const std::exception& e)
-            {
-                res_item["reason"] = std::string("Solver throws exception") + e.what();
-                std::cerr << "Exception during solution construction, solver_name: "
-                          << solver_id.ToString() << e.what() << std::endl;
-                return false;
-            }
-            res_item["reason"]         = "Success";
-            res_item["workspace"]      = solution.workspace_sz;
-            res_item["kernel_objects"] = BuildJsonKernelList(handle, solution.construction_params);
-            return true;
-        };
+        miopen::solver::ConvSolution solution;
+        try
+        {
+            // auto tune is not expected here
+            solution = s.FindSolution(solver_ctx, problem, db, {});
+        }
+        catch(const std::exception& e)
+        {
+            res_item["reason"] = std::string("Solver throws exception") + e.what();
+            std::cerr << "Exception during solution construction, solver_name: "
+                      << solver_id.ToString() << e.what() << std::endl;
+            return false;
+        }
+        res_item["reason"]    = "Success";
+        res_item["workspace"] = solution.workspace_sz;
+        res_item["kernel_objects"] =
+            BuildJsonKernelList(solver_handle, solution.construction_params);
+        return true;
+    };
 
-        auto res = process_solver();
+    // Solvers are independent of each other, each worker owns a handle, a
+    // context and a db and picks up the next unprocessed solver. Results are
+    // stored by solver index to keep the output order deterministic.
+    const size_t num_threads = std::min(GetNumThreads(job), solver_list.size());
+    std::vector<json> results(solver_list.size());
+    std::atomic<size_t> next_solver{0};
+    const auto worker = [&]() {
+        // cppcheck-suppress unreadVariable
+        auto worker_handle = miopen::Handle{};
+        BaseFin::InitNoGpuHandle(worker_handle, job_arch, job_cu);
+        auto worker_ctx = miopen::ConvolutionContext{};
+        worker_ctx.SetStream(&worker_handle);
+        problem.conv_problem.SetupFloats(worker_ctx);
+        auto db = GetDb(worker_ctx);
+        for(size_t idx = next_solver++; idx < solver_list.size(); idx = next_solver++)
+        {
+            json res_item;
+            auto res = process_solver(solver_list[idx], worker_handle, worker_ctx, db, res_item);
+            res_item["find_compiled"] = res;
+            results[idx]              = std::move(res_item);
+        }
+    };
 
-        res_item["find_compiled"] = res;
-        find_result.push_back(res_item);
+    // since applicability has been run, the solver list should come from Tuna
+    if(num_threads <= 1)
+    {
+        worker();
     }
+    else
+    {
+        std::cerr << "Compiling " << solver_list.size() << " solvers on " << num_threads
+                  << " threads" << std::endl;
+        ThreadPool pool(num_threads);
+        std::vector<std::future<void>> workers;
+        for(size_t idx = 0; idx < num_threads; idx++)
+            workers.push_back(pool.Submit(worker));
+        for(auto& w : workers)
+            w.get();
+    }
+    for(auto& res_item : results)
+        find_result.push_back(std::move(res_item));
     output["miopen_find_compile_result"] = find_result;
+    AddKernelBlobs(find_result);
     return 1;
 }
 
@@ -452,7 +750,10 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
 // alloc_buf, fill_buf and copy_buf_to_device if numerical accuracy would be
 // checked ??
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to run MIOpenPerfEval, Invalid MIOpen backend: HIPNOGPU");
+    // a host device runs the step with stub invokers
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to run MIOpenPerfEval, Invalid MIOpen backend: HIPNOGPU");
+    BaseFin::InitNoGpuHandle(GetHandle(), job["arch"], job["num_cu"]);
 #endif
     const auto conv_dir = GetDirection();
     // The first arg to the DataInvokeParams changes based on direction
@@ -485,19 +786,28 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
     std::cerr << "Job Arch: " << job["arch"] << ": Handle Arch: " << arch << std::endl;
     std::cerr << "Job Num CU: " << job["num_cu"] << ": Handle Num Cu: " << num_cu << std::endl;
 
-    for(const auto& kinder :
-        job["miopen_perf_compile_result"]) // The "miopen_perf_compile_result" list generated
-                                           // by miopen_perf_compile operation
+    // The "miopen_perf_compile_result" list generated by miopen_perf_compile operation
+    const auto& compile_results = job["miopen_perf_compile_result"];
+    // sized for the largest workspace upfront, reused by all the solvers
+    DeviceWorkspace().Reserve(
+        std::max(GetMaxWorkspace(compile_results), workspace.desc.GetNumBytes()));
+    // the kernels of the next solvers are decoded while the current one runs,
+    // unless the solver is going to be skipped
+    const auto is_evaluated = [&](const json& kinder) {
+        const std::string solver_name = kinder["solver_name"];
+        const auto& s                 = miopen::solver::Id{solver_name}.GetSolver();
+        return solver_name != "ConvBiasActivAsm1x1U" &&
+               solver_name.find("Fused") == std::string::npos && !s.IsEmpty() &&
+               s.IsApplicable(ctx, problem);
+    };
+    KernelPrefetcher prefetcher(compile_results, job, GetNumThreads(job), 0, is_evaluated);
+    for(size_t idx = 0; idx < compile_results.size(); idx++)
     {
+        const auto& kinder = compile_results[idx];
         // Somehow the direction changes mid loop !
         json res_item;
-        boost::system::error_code ec;
-        boost::filesystem::remove_all(miopen::GetCachePath(false), ec);
-        // boost::filesystem::remove_all(miopen::GetCachePath(true), ec);
-        if(ec)
-        {
-            std::cerr << "Error while removing MIOpen cache: " << ec.message();
-        }
+        // one result per perf config, when the compile result lists them
+        std::vector<json> cfg_items;
         auto process_solver = [&]() -> bool {
             const std::string solver_name = kinder["solver_name"];
             std::cerr << "Processing solver: " << solver_name << std::endl;
@@ -537,24 +847,20 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
             std::cerr << solver_name << " is applicable" << std::endl;
             // Get the binary
             std::cerr << "loading binaries from fin input" << std::endl;
-            for(const auto& kernel_obj : kinder["kernel_objects"])
+            for(const auto& kernel : prefetcher.Get(idx))
             {
-                const auto size          = kernel_obj["uncompressed_size"];
-                const auto md5_sum       = kernel_obj["md5_sum"];
-                const auto encoded_hsaco = kernel_obj["blob"];
-                const auto decoded_hsaco = base64_decode(encoded_hsaco);
-                const auto hsaco         = miopen::decompress(decoded_hsaco, size);
-
-                std::string kernel_file_no_ext = kernel_obj["kernel_file"];
-                std::string kernel_file        = kernel_file_no_ext + ".o";
-                std::string comp_opts          = kernel_obj["comp_options"];
+                const auto& hsaco = kernel.hsaco;
+
+                const std::string& kernel_file_no_ext = kernel.kernel_file;
+                std::string kernel_file               = kernel_file_no_ext + ".o";
+                std::string comp_opts                 = kernel.comp_options;
                 // LoadProgram doesn't add -mcpu for mlir
                 if(!miopen::EndsWith(kernel_file_no_ext, ".mlir"))
                 {
                     comp_opts += " -mcpu=" + h.GetDeviceName();
                 }
 
-                if(miopen::md5(hsaco) == md5_sum)
+                if(kernel.valid)
                 {
                     try
                     {
@@ -586,122 +892,75 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
                 }
             }
 
-            miopen::solver::ConvSolution solution;
-            solution = s.FindSolution(ctx, problem, db, {}); // auto tune is not expected here
-            res_item["workspace"] = solution.workspace_sz;
-
-            std::cerr << "Checking for workspace: " << solution.workspace_sz << std::endl;
-            if(solution.workspace_sz > workspace.desc.GetNumBytes())
-            {
-                std::cerr << "Allocating " << solution.workspace_sz << " bytes for workspace"
-                          << std::endl;
-                workspace = tensor<Tgpu, Tref>{
-                    q,
-                    std::vector<size_t>{static_cast<size_t>(solution.workspace_sz / sizeof(Tgpu))},
-                    false,
-                    false};
-                workspace.AllocateBuffers();
-            }
-            if(!solution.invoker_factory)
+            // "params" in the compile result selects the perf configs to time, each one
+            // is constructed once, without a search
+            const auto perf_cfgs = GetCompiledPerfCfgs(kinder);
+            if(!perf_cfgs.empty())
             {
-                std::cerr << "Invoker not implemeted" << std::endl;
-                res_item["reason"] = "Invoker not implemented";
-                return false;
+                ctx.do_search = false;
+                ctx.db_update = false;
+                for(const auto& perf_cfg : perf_cfgs)
+                {
+                    json cfg_item         = res_item;
+                    cfg_item["params"]    = perf_cfg;
+                    cfg_item["evaluated"] = EvalPerfCfg(
+                        s, ctx, problem, db, perf_cfg, kinder["kernel_objects"], cfg_item);
+                    cfg_items.push_back(std::move(cfg_item));
+                }
+                return true;
             }
 
             try
             {
-                float kernel_time = -1;
-                ctx.do_search     = true;
-                ctx.db_update     = true;
-
-                // This is required because DataInvokeParams switches tensor order due to
-                // direction and it does not have a
-                // copy constructor or a default constructor
+                miopen::solver::ConvSolution solution;
+                BenchmarkStats time_stats;
+                // there is nothing to search with the stub invokers of a host device
+                ctx.do_search = !DeviceAllocator()->IsHost();
+                ctx.db_update = ctx.do_search;
+
+                // the searched solution is the only one constructed, the
+                // workspace grows to fit it before it is timed
                 std::cerr << "Find Solution" << std::endl;
-                if(conv_dir == miopen::conv::Direction::Forward)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetFwd()};
-
+                VisitInvokeParams([&](const auto& invoke_ctx) {
                     solution = s.FindSolution(ctx, problem, db, invoke_ctx); // forcing search here
-                    // check if binaries were added, prep invoker for gathering timing
-                    SolutionHasProgram(h, solution);
-
-                    const auto invoker =
-                        h.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else if(conv_dir == miopen::conv::Direction::BackwardData)
+                });
+                res_item["workspace"] = solution.workspace_sz;
+                if(!solution.invoker_factory)
                 {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetBwd()};
-
-                    solution = s.FindSolution(ctx, problem, db, invoke_ctx); // forcing search here
-                    // check if binaries were added, prep invoker for gathering timing
-                    SolutionHasProgram(h, solution);
-
-                    const auto invoker =
-                        h.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
+                    std::cerr << "Invoker not implemeted" << std::endl;
+                    res_item["reason"] = "Invoker not implemented";
+                    return false;
                 }
-                else if(conv_dir == miopen::conv::Direction::BackwardWeights)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::WrWInvokeParams{{outputTensor.desc,
-                                                       outputTensor.gpuData.buf.get(),
-                                                       inputTensor.desc,
-                                                       inputTensor.gpuData.buf.get(),
-                                                       weightTensor.desc,
-                                                       weightTensor.gpuData.buf.get()},
-                                                      workspace.gpuData.buf.get(),
-                                                      workspace.desc.GetNumBytes(),
-                                                      convDesc.attribute.gfx90aFp16alt.GetWrW()};
-
-                    solution = s.FindSolution(ctx, problem, db, invoke_ctx); // forcing search here
-                    // check if binaries were added, prep invoker for gathering timing
-                    SolutionHasProgram(h, solution);
 
-                    const auto invoker =
-                        h.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else
+                std::cerr << "Checking for workspace: " << solution.workspace_sz << std::endl;
+                if(solution.workspace_sz > DeviceWorkspace().Size())
                 {
-                    ss.str("");
-                    ss << "Invalid Direction: solver " << solver_name << ", dir "
-                       << static_cast<int>(conv_dir);
-                    throw std::runtime_error(ss.str());
+                    std::cerr << "Growing workspace to " << solution.workspace_sz << " bytes"
+                              << std::endl;
+                    DeviceWorkspace().Reserve(solution.workspace_sz);
                 }
 
+                // check if binaries were added, prep invoker for gathering timing
+                SolutionHasProgram(h, solution);
+                const auto invoker = PrepareTimedInvoker(h, solution);
+                VisitInvokeParams([&](const auto& invoke_ctx) {
+                    time_stats = BenchmarkInvoker(invoker, h, invoke_ctx);
+                });
+
                 params    = s.GetPerfCfgParams(ctx, problem, db);
-                kern_objs = BuildJsonKernelList(h, solution.construction_params);
+                kern_objs = BuildJsonKernelRefs(
+                    h, solution.construction_params, kinder["kernel_objects"]);
 
                 res_item["params"]         = params;
-                res_item["time"]           = kernel_time;
+                res_item["time"]           = time_stats.median;
+                res_item["time_stats"]     = time_stats.ToJson();
                 res_item["layout"]         = problem.GetInLayout();
                 res_item["data_type"]      = problem.GetInDataType();
                 res_item["direction"]      = conv_dir;
                 res_item["bias"]           = problem.GetBias();
                 res_item["kernel_objects"] = kern_objs;
                 res_item["reason"]         = "Success";
-                if(kernel_time == 0.0)
+                if(time_stats.median == 0.0)
                     res_item["reason"] = "Invoker returned time = 0";
             }
             catch(const std::exception& e)
@@ -713,11 +972,17 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
             return true;
         };
 
-        auto res              = process_solver();
-        res_item["evaluated"] = res;
-        perf_result.push_back(res_item);
+        auto res = process_solver();
+        if(cfg_items.empty())
+        {
+            res_item["evaluated"] = res;
+            perf_result.push_back(res_item);
+        }
+        for(auto& cfg_item : cfg_items)
+            perf_result.push_back(std::move(cfg_item));
     }
     output["miopen_perf_eval_result"] = perf_result;
+    AddKernelBlobs(perf_result);
     return 1;
 #else
     throw std::runtime_error("Unsupported feature");
@@ -725,6 +990,62 @@ int ConvFin<Tgpu, Tref>::MIOpenPerfEval()
 #endif
 }
 
+// Times the solution of a solver for the given perf config. The solution is
+// constructed once, from the perf config, the kernels must have been loaded.
+template <typename Tgpu, typename Tref>
+bool ConvFin<Tgpu, Tref>::EvalPerfCfg(const miopen::solver::AnySolver& s,
+                                      const miopen::ConvolutionContext& ctx,
+                                      const miopen::ProblemDescription& problem,
+                                      miopen::PerformanceDb& db,
+                                      const std::string& perf_cfg,
+                                      const json& input_kernels,
+                                      json& res_item)
+{
+    auto& h = GetHandle();
+    if(!s.TestPerfCfgParams(ctx, problem, perf_cfg))
+    {
+        res_item["reason"] = "Invalid params";
+        std::cerr << "Invalid params: " << perf_cfg << std::endl;
+        return false;
+    }
+    try
+    {
+        const auto solution = s.FindSolution(ctx, problem, db, {}, perf_cfg);
+        res_item["workspace"] = solution.workspace_sz;
+        if(!solution.invoker_factory)
+        {
+            res_item["reason"] = "Invoker not implemented";
+            return false;
+        }
+        DeviceWorkspace().Reserve(solution.workspace_sz);
+        SolutionHasProgram(h, solution);
+
+        BenchmarkStats time_stats;
+        const auto invoker = PrepareTimedInvoker(h, solution);
+        VisitInvokeParams([&](const auto& invoke_ctx) {
+            time_stats = BenchmarkInvoker(invoker, h, invoke_ctx);
+        });
+
+        res_item["time"]           = time_stats.median;
+        res_item["time_stats"]     = time_stats.ToJson();
+        res_item["layout"]         = problem.GetInLayout();
+        res_item["data_type"]      = problem.GetInDataType();
+        res_item["direction"]      = GetDirection();
+        res_item["bias"]           = problem.GetBias();
+        res_item["kernel_objects"] =
+            BuildJsonKernelRefs(h, solution.construction_params, input_kernels);
+        res_item["reason"]         = "Success";
+        if(time_stats.median == 0.0)
+            res_item["reason"] = "Invoker returned time = 0";
+    }
+    catch(const std::exception& e)
+    {
+        res_item["reason"] = std::string("Invoker exception: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
 template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::MIOpenFindEval()
 {
@@ -735,7 +1056,10 @@ int ConvFin<Tgpu, Tref>::MIOpenFindEval()
 // alloc_buf, fill_buf and copy_buf_to_device if numerical accuracy would be
 // checked ??
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to run MIOpenFindEval, Invalid MIOpen backend: HIPNOGPU");
+    // a host device runs the step with stub invokers
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to run MIOpenFindEval, Invalid MIOpen backend: HIPNOGPU");
+    BaseFin::InitNoGpuHandle(GetHandle(), job["arch"], job["num_cu"]);
 #endif
     const auto conv_dir = GetDirection();
     // The first arg to the DataInvokeParams changes based on direction
@@ -771,19 +1095,23 @@ int ConvFin<Tgpu, Tref>::MIOpenFindEval()
     if(job.contains("dynamic_only"))
         dynamic_only = job["dynamic_only"];
 
-    for(const auto& kinder :
-        job["miopen_find_compile_result"]) // The "miopen_find_compile_result" list generated
-                                           // by miopen_find_compile operation
+    // The "miopen_find_compile_result" list generated by miopen_find_compile operation
+    const auto& compile_results = job["miopen_find_compile_result"];
+    // sized for the largest workspace upfront, reused by all the solvers
+    DeviceWorkspace().Reserve(
+        std::max(GetMaxWorkspace(compile_results), workspace.desc.GetNumBytes()));
+    // the kernels of the next solvers are decoded while the current one runs,
+    // unless the solver is going to be skipped
+    const auto is_evaluated = [&](const json& kinder) {
+        const auto& s = miopen::solver::Id{kinder["solver_name"].get<std::string>()}.GetSolver();
+        return !s.IsEmpty() && s.IsApplicable(ctx, problem) && !(dynamic_only && !s.IsDynamic());
+    };
+    KernelPrefetcher prefetcher(compile_results, job, GetNumThreads(job), 0, is_evaluated);
+    for(size_t idx = 0; idx < compile_results.size(); idx++)
     {
+        const auto& kinder = compile_results[idx];
         // Somehow the direction changes mid loop !
         json res_item;
-        boost::system::error_code ec;
-        boost::filesystem::remove_all(miopen::GetCachePath(false), ec);
-        // boost::filesystem::remove_all(miopen::GetCachePath(true), ec);
-        if(ec)
-        {
-            std::cerr << "Error while removing MIOpen cache: " << ec.message();
-        }
         auto process_solver = [&]() -> bool {
             const std::string solver_name = kinder["solver_name"];
             std::cerr << "Processing solver: " << solver_name << std::endl;
@@ -820,24 +1148,20 @@ int ConvFin<Tgpu, Tref>::MIOpenFindEval()
             std::cerr << solver_name << " is applicable" << std::endl;
             // Get the binary
             std::cerr << "loading binaries from fin input" << std::endl;
-            for(const auto& kernel_obj : kinder["kernel_objects"])
+            for(const auto& kernel : prefetcher.Get(idx))
             {
-                const auto size          = kernel_obj["uncompressed_size"];
-                const auto md5_sum       = kernel_obj["md5_sum"];
-                const auto encoded_hsaco = kernel_obj["blob"];
-                const auto decoded_hsaco = base64_decode(encoded_hsaco);
-                const auto hsaco         = miopen::decompress(decoded_hsaco, size);
-
-                std::string kernel_file_no_ext = kernel_obj["kernel_file"];
-                std::string kernel_file        = kernel_file_no_ext + ".o";
-                std::string comp_opts          = kernel_obj["comp_options"];
+                const auto& hsaco = kernel.hsaco;
+
+                const std::string& kernel_file_no_ext = kernel.kernel_file;
+                std::string kernel_file               = kernel_file_no_ext + ".o";
+                std::string comp_opts                 = kernel.comp_options;
                 // LoadProgram doesn't add -mcpu for mlir
                 if(!miopen::EndsWith(kernel_file_no_ext, ".mlir"))
                 {
                     comp_opts += " -mcpu=" + h.GetDeviceName();
                 }
 
-                if(miopen::md5(hsaco) == md5_sum)
+                if(kernel.valid)
                 {
                     try
                     {
@@ -865,16 +1189,11 @@ int ConvFin<Tgpu, Tref>::MIOpenFindEval()
             SolutionHasProgram(h, solution);
 
             std::cerr << "Checking for workspace" << std::endl;
-            if(solution.workspace_sz > workspace.desc.GetNumBytes())
+            if(solution.workspace_sz > DeviceWorkspace().Size())
             {
-                std::cerr << "Allocating " << solution.workspace_sz << " bytes for workspace"
+                std::cerr << "Growing workspace to " << solution.workspace_sz << " bytes"
                           << std::endl;
-                workspace = tensor<Tgpu, Tref>{
-                    q,
-                    std::vector<size_t>{static_cast<size_t>(solution.workspace_sz / sizeof(Tgpu))},
-                    false,
-                    false};
-                workspace.AllocateBuffers();
+                DeviceWorkspace().Reserve(solution.workspace_sz);
             }
             if(!solution.invoker_factory)
             {
@@ -884,66 +1203,20 @@ int ConvFin<Tgpu, Tref>::MIOpenFindEval()
             }
             try
             {
-                float kernel_time = -1;
+                BenchmarkStats time_stats;
 
                 std::cerr << "Preparing invokers" << std::endl;
-                const auto invoker =
-                    h.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
+                const auto invoker = PrepareTimedInvoker(h, solution);
                 std::cerr << "Finished preparing invokers" << std::endl;
 
-                // This is required because DataInvokeParams switches tensor order due to
-                // direction and it does not have a
-                // copy constructor or a default constructor
-                if(conv_dir == miopen::conv::Direction::Forward)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetFwd()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else if(conv_dir == miopen::conv::Direction::BackwardData)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetBwd()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else if(conv_dir == miopen::conv::Direction::BackwardWeights)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::WrWInvokeParams{{outputTensor.desc,
-                                                       outputTensor.gpuData.buf.get(),
-                                                       inputTensor.desc,
-                                                       inputTensor.gpuData.buf.get(),
-                                                       weightTensor.desc,
-                                                       weightTensor.gpuData.buf.get()},
-                                                      workspace.gpuData.buf.get(),
-                                                      workspace.desc.GetNumBytes(),
-                                                      convDesc.attribute.gfx90aFp16alt.GetWrW()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else
-                {
-                    throw std::runtime_error("Invalid Direction");
-                }
+                VisitInvokeParams([&](const auto& invoke_ctx) {
+                    time_stats = BenchmarkInvoker(invoker, h, invoke_ctx);
+                });
 
-                res_item["time"]   = kernel_time;
-                res_item["reason"] = "Success";
-                if(kernel_time == 0.0)
+                res_item["time"]       = time_stats.median;
+                res_item["time_stats"] = time_stats.ToJson();
+                res_item["reason"]     = "Success";
+                if(time_stats.median == 0.0)
                     res_item["reason"] = "Invoker returned time = 0";
             }
             catch(const std::exception& e)
@@ -1000,6 +1273,7 @@ int ConvFin<Tgpu, Tref>::MIOpenFind()
     assert(arch == job["arch"]);
     const size_t num_cu = h.GetMaxComputeUnits();
     assert(num_cu == job["num_cu"]);
+    DeviceWorkspace().Reserve(workspace.desc.GetNumBytes());
     for(const auto& solver_id :
         miopen::solver::GetSolversByPrimitive(miopen::solver::Primitive::Convolution))
     {
@@ -1072,64 +1346,19 @@ int ConvFin<Tgpu, Tref>::MIOpenFind()
             }
             try
             {
-                float kernel_time = -1;
+                BenchmarkStats time_stats;
 
                 const auto invoker =
                     h.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
 
-                // This required because DataInvokeParams switches tensor order
-                // due to direction and it does not have a
-                // copy constructor or a default constructor
-                if(conv_dir == miopen::conv::Direction::Forward)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetFwd()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else if(conv_dir == miopen::conv::Direction::BackwardData)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::DataInvokeParams{{outputTensor.desc,
-                                                        outputTensor.gpuData.buf.get(),
-                                                        weightTensor.desc,
-                                                        weightTensor.gpuData.buf.get(),
-                                                        inputTensor.desc,
-                                                        inputTensor.gpuData.buf.get()},
-                                                       workspace.gpuData.buf.get(),
-                                                       workspace.desc.GetNumBytes(),
-                                                       convDesc.attribute.gfx90aFp16alt.GetBwd()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else if(conv_dir == miopen::conv::Direction::BackwardWeights)
-                {
-                    const auto invoke_ctx =
-                        miopen::conv::WrWInvokeParams{{outputTensor.desc,
-                                                       outputTensor.gpuData.buf.get(),
-                                                       inputTensor.desc,
-                                                       inputTensor.gpuData.buf.get(),
-                                                       weightTensor.desc,
-                                                       weightTensor.gpuData.buf.get()},
-                                                      workspace.gpuData.buf.get(),
-                                                      workspace.desc.GetNumBytes(),
-                                                      convDesc.attribute.gfx90aFp16alt.GetWrW()};
-                    kernel_time = BenchmarkInvoker(invoker, h, invoke_ctx);
-                }
-                else
-                {
-                    throw std::runtime_error("Invalid Direction");
-                }
+                VisitInvokeParams([&](const auto& invoke_ctx) {
+                    time_stats = BenchmarkInvoker(invoker, h, invoke_ctx);
+                });
 
-                res_item["time"]   = kernel_time;
-                res_item["reason"] = "Success";
-                if(kernel_time == 0.0)
+                res_item["time"]       = time_stats.median;
+                res_item["time_stats"] = time_stats.ToJson();
+                res_item["reason"]     = "Success";
+                if(time_stats.median == 0.0)
                     res_item["reason"] = "Invoker returned time = 0";
             }
             catch(const std::exception& e)
@@ -1218,7 +1447,7 @@ int ConvFin<Tgpu, Tref>::TestPerfDbEntries(
     const miopen::ProblemDescription& problem,
     const std::map<std::string, std::unordered_map<std::string, std::string>>& perf_ids,
     std::vector<std::map<std::string, std::string>>& err_list,
-    std::vector<std::string>& pdb_id)
+    std::vector<std::string>& pdb_id) const
 {
     bool ret = true;
 
@@ -1286,9 +1515,42 @@ int ConvFin<Tgpu, Tref>::TestPerfDbValid()
         db_path = job["db_path"];
     std::cout << db_path << std::endl;
 
+    using PerfIds = std::map<std::string, std::unordered_map<std::string, std::string>>;
+    using ErrList = std::vector<std::map<std::string, std::string>>;
+    // a config of the db file under test with the outcome of its validation
+    struct ConfigTask
+    {
+        const std::string* config_id;
+        const PerfIds* perf_ids;
+        json command;
+        std::string read_error;
+        ErrList err_list;
+        std::vector<std::string> pdb_id;
+    };
+    const auto add_error = [](const std::string& reason,
+                              const std::string& perf_id,
+                              const std::string& config_id,
+                              const std::string& solver_nm,
+                              const std::string& params,
+                              ErrList& err_list,
+                              std::vector<std::string>& pdb_id) {
+        std::map<std::string, std::string> err;
+        err["reason"]    = reason;
+        err["perfdb_id"] = perf_id;
+        err["config"]    = config_id;
+        err["solver"]    = solver_nm;
+        err["params"]    = params;
+        err_list.push_back(err);
+        pdb_id.push_back(perf_id);
+    };
+
     std::vector<fs::path> contents;
     std::copy(
         fs::directory_iterator(db_path), fs::directory_iterator(), std::back_inserter(contents));
+    // the merged output does not depend on the order of the directory listing
+    std::sort(contents.begin(), contents.end());
+    // The files are validated one after another, only the entries of the
+    // current file are held in memory
     for(auto const& db_file : contents)
     {
         std::string pathstr = db_file.native();
@@ -1321,9 +1583,6 @@ int ConvFin<Tgpu, Tref>::TestPerfDbValid()
 
         if(spec_arch)
         {
-            std::stringstream str_cu;
-            str_cu << job["num_cu"];
-
             if(db_arch.compare(job["arch"]) != 0)
                 continue;
             if(db_num_cu != job["num_cu"])
@@ -1331,119 +1590,170 @@ int ConvFin<Tgpu, Tref>::TestPerfDbValid()
         }
 
         std::cerr << "processing: " << pathstr << std::endl;
-
-        // set handle to type of db under test
-        auto handle = miopen::Handle{};
-        BaseFin::InitNoGpuHandle(handle, db_arch, db_num_cu);
-
-        // setting system to false allows writing the db
-        auto sql = miopen::SQLite{pathstr, false};
-
         // cfg -> pdb_id -> values_dict
-        std::map<std::string, std::map<std::string, std::unordered_map<std::string, std::string>>>
-            perfdb_entries;
-        std::vector<std::map<std::string, std::string>> err_list;
-        std::map<std::string, int> err_sum;
+        std::map<std::string, PerfIds> perfdb_entries;
+        // cfg -> command, missing for configs not in the config table
+        std::map<std::string, json> commands;
+        ErrList err_list;
         std::vector<std::string> pdb_id;
-        auto select_query = "SELECT config, solver, params, id FROM perf_db;";
-        auto stmt         = miopen::SQLite::Statement{sql, select_query};
-        while(true)
+
+        // the whole file is read in a single pass, each perf db row comes with
+        // its config, which is turned into a command the first time it is seen.
+        // The connection is closed before the file is cleaned up.
         {
-            auto rc = stmt.Step(sql);
-            if(rc == SQLITE_ROW)
+            auto sql                = miopen::SQLite{pathstr, false};
+            const auto select_query =
+                "SELECT perf_db.config, perf_db.solver, perf_db.params, perf_db.id, "
+                "config.id IS NOT NULL, " +
+                ConvConfigColumns() +
+                " FROM perf_db LEFT JOIN config ON config.id = perf_db.config;";
+            auto stmt = miopen::SQLite::Statement{sql, select_query};
+            while(true)
             {
-                const auto config_id = stmt.ColumnText(0);
-                const auto solver_nm = stmt.ColumnText(1);
-                const auto params    = stmt.ColumnText(2);
-                const auto perf_id   = stmt.ColumnText(3);
-                const auto slv_id    = miopen::solver::Id(solver_nm);
-
-                if(!slv_id.IsValid())
+                auto rc = stmt.Step(sql);
+                if(rc == SQLITE_ROW)
                 {
-                    std::map<std::string, std::string> err;
-                    err["reason"]    = "invalid solver";
-                    err["perfdb_id"] = perf_id;
-                    err["config"]    = config_id;
-                    err["solver"]    = solver_nm;
-                    err["params"]    = params;
-                    err_list.push_back(err);
-                    ret = false;
-                    pdb_id.push_back(perf_id);
-                    continue;
-                }
+                    const auto config_id = stmt.ColumnText(0);
+                    const auto solver_nm = stmt.ColumnText(1);
+                    const auto params    = stmt.ColumnText(2);
+                    const auto perf_id   = stmt.ColumnText(3);
+                    const auto slv_id    = miopen::solver::Id(solver_nm);
 
-                if(solver_nm == "ConvBiasActivAsm1x1U" ||
-                   solver_nm.find("Fused") != std::string::npos)
-                {
-                    std::cerr << "Skipping fused solver: " << solver_nm << std::endl;
-                    continue;
-                }
+                    if(!slv_id.IsValid())
+                    {
+                        add_error("invalid solver",
+                                  perf_id,
+                                  config_id,
+                                  solver_nm,
+                                  params,
+                                  err_list,
+                                  pdb_id);
+                        ret = false;
+                        continue;
+                    }
+
+                    if(solver_nm == "ConvBiasActivAsm1x1U" ||
+                       solver_nm.find("Fused") != std::string::npos)
+                    {
+                        std::cerr << "Skipping fused solver: " << solver_nm << std::endl;
+                        continue;
+                    }
 
-                perfdb_entries[config_id][perf_id]["solver"] = solver_nm;
-                perfdb_entries[config_id][perf_id]["params"] = params;
+                    perfdb_entries[config_id][perf_id]["solver"] = solver_nm;
+                    perfdb_entries[config_id][perf_id]["params"] = params;
+                    if(stmt.ColumnInt64(4) != 0 && commands.count(config_id) == 0)
+                        commands[config_id] = ReadConvConfig(stmt, 5, config_id);
+                }
+                else if(rc == SQLITE_DONE)
+                    break;
+                else if(rc == SQLITE_ERROR || rc == SQLITE_MISUSE)
+                    MIOPEN_THROW(miopenStatusInternalError, sql.ErrorMessage());
             }
-            else if(rc == SQLITE_DONE)
-                break;
-            else if(rc == SQLITE_ERROR || rc == SQLITE_MISUSE)
-                MIOPEN_THROW(miopenStatusInternalError, sql.ErrorMessage());
         }
 
-        // iterate through each config
-        for(auto cfg_it = perfdb_entries.begin(); cfg_it != perfdb_entries.end(); cfg_it++)
+        std::vector<ConfigTask> tasks;
+        for(const auto& cfg : perfdb_entries)
         {
-            const auto& config_id          = cfg_it->first;
-            const auto& perf_ids           = cfg_it->second;
-            miopen::ConvolutionContext ctx = miopen::ConvolutionContext{};
-            miopen::ProblemDescription problem;
-
-            std::cerr << "building problem" << std::endl;
-            try
-            {
-                problem = BuildConvProblem(sql, config_id);
-            }
-            catch(const std::exception& e)
+            tasks.push_back({&cfg.first, &cfg.second, {}, {}, {}, {}});
+            const auto command = commands.find(cfg.first);
+            if(command != commands.end())
+                tasks.back().command = std::move(command->second);
+            else
+                tasks.back().read_error = "config not found";
+        }
+        commands.clear();
+
+        // Configs are independent of each other. Each worker keeps a NOGPU
+        // handle of the file arch and picks up the next unprocessed config, the
+        // errors are stored with the config and merged in config order
+        // afterwards.
+        std::atomic<size_t> next_task{0};
+        const auto worker = [&]() {
+            std::unique_ptr<miopen::Handle> handle;
+            for(size_t idx = next_task++; idx < tasks.size(); idx = next_task++)
             {
-                std::cerr << "Error in BuildContext: " << e.what() << std::endl;
+                auto& task       = tasks[idx];
+                auto build_error = task.read_error;
+                miopen::ProblemDescription problem;
 
-                for(auto pdb_it = perf_ids.begin(); pdb_it != perf_ids.end(); pdb_it++)
+                if(build_error.empty())
                 {
-                    const auto& perf_id   = pdb_it->first;
-                    const auto& solver_nm = pdb_it->second.find("solver")->second;
-                    const auto& params    = pdb_it->second.find("params")->second;
-
-                    std::map<std::string, std::string> err;
-                    err["reason"]    = e.what();
-                    err["perfdb_id"] = perf_id;
-                    err["config"]    = config_id;
-                    err["solver"]    = solver_nm;
-                    err["params"]    = params;
-                    err_list.push_back(err);
-                    ret = false;
-                    pdb_id.push_back(perf_id);
+                    try
+                    {
+                        problem = BuildConvProblem(task.command);
+                    }
+                    catch(const std::exception& e)
+                    {
+                        build_error = e.what();
+                    }
                 }
-                continue;
+                if(!build_error.empty())
+                {
+                    std::cerr << "config_id: " << *task.config_id
+                              << ", error in BuildContext: " << build_error << std::endl;
+                    for(const auto& pdb : *task.perf_ids)
+                    {
+                        add_error(build_error,
+                                  pdb.first,
+                                  *task.config_id,
+                                  pdb.second.find("solver")->second,
+                                  pdb.second.find("params")->second,
+                                  task.err_list,
+                                  task.pdb_id);
+                    }
+                    continue;
+                }
+
+                if(handle == nullptr)
+                {
+                    handle = std::make_unique<miopen::Handle>();
+                    BaseFin::InitNoGpuHandle(*handle, db_arch, db_num_cu);
+                }
+                auto ctx = miopen::ConvolutionContext{};
+                ctx.SetStream(handle.get());
+                problem.conv_problem.SetupFloats(ctx);
+
+                TestPerfDbEntries(
+                    *task.config_id, ctx, problem, *task.perf_ids, task.err_list, task.pdb_id);
             }
-            ctx.SetStream(&handle);
-            problem.conv_problem.SetupFloats(ctx);
+        };
+
+        const size_t num_threads = std::min(GetNumThreads(job), tasks.size());
+        if(num_threads <= 1)
+        {
+            worker();
+        }
+        else
+        {
+            std::cerr << "Validating " << tasks.size() << " configs of " << filestr << " on "
+                      << num_threads << " threads" << std::endl;
+            ThreadPool pool(num_threads);
+            std::vector<std::future<void>> workers;
+            for(size_t idx = 0; idx < num_threads; idx++)
+                workers.push_back(pool.Submit(worker));
+            for(auto& w : workers)
+                w.get();
+        }
 
-            std::cerr << "test pdb" << std::endl;
-            bool success = TestPerfDbEntries(config_id, ctx, problem, perf_ids, err_list, pdb_id);
-            if(not success)
+        for(auto& task : tasks)
+        {
+            if(!task.err_list.empty())
                 ret = false;
+            std::move(task.err_list.begin(), task.err_list.end(), std::back_inserter(err_list));
+            std::move(task.pdb_id.begin(), task.pdb_id.end(), std::back_inserter(pdb_id));
         }
+
         output[filestr]["errors"] = err_list;
 
+        std::map<std::string, int> err_sum;
         for(auto& val : err_list)
-        {
-            if(err_sum.count(val["solver"]) == 0)
-                err_sum[val["solver"]] = 1;
-            else
-                err_sum[val["solver"]] += 1;
-        }
+            err_sum[val["solver"]] += 1;
         output[filestr]["error_summary"] = err_sum;
 
         if(job.contains("cleanup") && job["cleanup"])
         {
+            // setting system to false allows writing the db
+            auto sql = miopen::SQLite{pathstr, false};
             std::ostringstream id_str, del_query;
             for(auto it = pdb_id.begin(); it != pdb_id.end(); it++)
             {
@@ -1454,8 +1764,8 @@ int ConvFin<Tgpu, Tref>::TestPerfDbValid()
             del_query << "DELETE from perf_db where id in (" << id_str.str()
                       << "); DELETE from config where not id in (select distinct config from "
                          "perf_db); VACUUM;";
-            stmt    = miopen::SQLite::Statement{sql, del_query.str()};
-            auto rc = stmt.Step(sql);
+            auto stmt = miopen::SQLite::Statement{sql, del_query.str()};
+            auto rc   = stmt.Step(sql);
             std::cerr << "delete status: " << rc << std::endl;
 
             output[filestr]["sql_del"]    = del_query.str();
@@ -1646,34 +1956,103 @@ template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::CopyToDevice()
 {
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to copy buffers to device with NOGPU backend");
-    return -1;
-#else
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to copy buffers to device with NOGPU backend");
+#endif
     auto status = inputTensor.ToDevice();
     status |= inputTensor_vect4.ToDevice();
     status |= weightTensor.ToDevice();
     status |= outputTensor.ToDevice();
     status |= biasTensor.ToDevice();
-    status |= workspace.ToDevice();
     return status;
-#endif
 }
 
 template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::CopyFromDevice()
 {
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to copy buffers to device with NOGPU backend");
-    return -1;
-#else
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to copy buffers from device with NOGPU backend");
+#endif
     auto status = inputTensor.FromDevice();
     status |= inputTensor_vect4.FromDevice();
     status |= weightTensor.FromDevice();
     status |= outputTensor.FromDevice();
     status |= biasTensor.FromDevice();
-    status |= workspace.FromDevice();
     return status;
-#endif
+}
+
+// Relative RMS error allowed between the device result and the CPU
+// reference, the same bounds the MIOpen driver uses
+inline double GetVerifyTolerance(miopenDataType_t data_type)
+{
+    switch(data_type)
+    {
+    case miopenFloat: return 1.5e-6;
+    case miopenHalf: return 8.2e-3;
+    case miopenBFloat16: return 8.2e-3 * 8;
+    default: throw std::runtime_error("No verification tolerance for the data type");
+    }
+}
+
+// Compares the result of the last solver run, as copied back by
+// copy_buf_from_device, against a CPU reference computed from the host
+// copies of the input tensors
+template <typename Tgpu, typename Tref>
+int ConvFin<Tgpu, Tref>::VerifyOutput()
+{
+    if(data_type == miopenInt8)
+        throw std::runtime_error("Verification is not supported for int8 convolutions");
+    for(const auto* layout : {"in_layout", "wei_layout", "out_layout"})
+        if(command[layout].get<std::string>().find('c') != std::string::npos)
+            throw std::runtime_error("Verification is not supported for vectorized layouts");
+
+    auto& result = is_fwd ? outputTensor : (is_bwd ? inputTensor : weightTensor);
+    if(result.deviceData.empty())
+        throw std::runtime_error("Nothing to verify, run copy_buf_from_device first");
+
+    CpuConvProblem problem;
+    const auto spatial_dim = convDesc.GetSpatialDimension();
+    problem.groups         = convDesc.group_count;
+    for(size_t dim = 0; dim < spatial_dim; dim++)
+    {
+        const size_t view_dim       = dim + 3 - spatial_dim;
+        problem.pads[view_dim]      = convDesc.GetConvPads()[dim];
+        problem.strides[view_dim]   = convDesc.GetConvStrides()[dim];
+        problem.dilations[view_dim] = convDesc.GetConvDilations()[dim];
+    }
+
+    // A transposed convolution is the regular one with x and y swapped
+    const bool trans = convDesc.mode == miopenTranspose;
+    const auto& x    = trans ? outputTensor : inputTensor;
+    const auto& y    = trans ? inputTensor : outputTensor;
+    const auto x_in  = x.MakeCpuView(x.cpuData.data());
+    const auto y_in  = y.MakeCpuView(y.cpuData.data());
+    const auto w_in  = weightTensor.MakeCpuView(weightTensor.cpuData.data());
+    const auto out   = result.MakeCpuView(result.deviceData.data());
+
+    std::vector<double> ref_data(out.ElementSize());
+    const CpuTensorView<double> ref{ref_data.data(), out.lens, PackedStrides(out.lens)};
+    const auto num_threads = GetNumThreads(job);
+    if(is_wrw)
+        ConvWrwCpu(problem, x_in, y_in, ref, num_threads);
+    else if(is_fwd != trans)
+        ConvFwdCpu(problem, x_in, w_in, ref, num_threads);
+    else
+        ConvBwdDataCpu(problem, y_in, w_in, ref, num_threads);
+
+    const auto stats     = CompareToReference(out, ref);
+    const auto tolerance = job.value("verify_tolerance", GetVerifyTolerance(data_type));
+    const bool passed    = stats.num_nans == 0 && stats.rms <= tolerance;
+    if(!passed)
+        std::cerr << "Verification failed, rms error " << stats.rms << " tolerance " << tolerance
+                  << " nans " << stats.num_nans << std::endl;
+    output["verify_result"] = {{"passed", passed},
+                               {"rms", stats.rms},
+                               {"tolerance", tolerance},
+                               {"max_abs_error", stats.max_abs_error},
+                               {"num_nans", stats.num_nans}};
+    return 0;
 }
 
 template <typename Tgpu, typename Tref>
@@ -1689,6 +2068,8 @@ int ConvFin<Tgpu, Tref>::ProcessStep(const std::string& step_name)
         return CopyToDevice();
     if(step_name == "copy_buf_from_device")
         return CopyFromDevice();
+    if(step_name == "verify")
+        return VerifyOutput();
     if(step_name == "applicability")
         return TestApplicability();
     if(step_name == "perf_db_test")
@@ -1705,6 +2086,8 @@ int ConvFin<Tgpu, Tref>::ProcessStep(const std::string& step_name)
     }
     if(step_name == "miopen_perf_compile")
         return MIOpenPerfCompile();
+    if(step_name == "miopen_perf_cfg_count")
+        return MIOpenPerfCfgCount();
     if(step_name == "miopen_perf_eval")
         return MIOpenPerfEval();
     return 0;
@@ -2046,88 +2429,98 @@ miopen::ProblemDescription ConvFin<Tgpu, Tref>::GetCmdConvProblem(json _command)
 }
 
 template <typename Tgpu, typename Tref>
-miopen::ProblemDescription ConvFin<Tgpu, Tref>::BuildConvProblem(miopen::SQLite& sql,
-                                                                 std::string config_id)
+std::string ConvFin<Tgpu, Tref>::ConvConfigColumns()
 {
-    std::ostringstream ss;
-    ss << "SELECT in_d, in_h, in_w, fil_d, fil_h, fil_w, pad_d, pad_h, pad_w, "
-          "conv_stride_d, conv_stride_h, conv_stride_w, dilation_d, dilation_h, "
-          "dilation_w, spatial_dim, layout, data_type, direction, "
-          "out_channels, in_channels, batchsize, group_count, bias "
-          "FROM config WHERE id=";
-    ss << config_id << ";";
-    auto cfg_query = ss.str();
-    auto stmt      = miopen::SQLite::Statement{sql, cfg_query};
-    stmt.Step(sql);
+    return "in_d, in_h, in_w, fil_d, fil_h, fil_w, pad_d, pad_h, pad_w, "
+           "conv_stride_d, conv_stride_h, conv_stride_w, dilation_d, dilation_h, "
+           "dilation_w, spatial_dim, layout, data_type, direction, "
+           "out_channels, in_channels, batchsize, group_count, bias";
+}
+
+template <typename Tgpu, typename Tref>
+json ConvFin<Tgpu, Tref>::ReadConvConfig(miopen::SQLite::Statement& stmt,
+                                         int first,
+                                         const std::string& config_id)
+{
+    const auto col_int  = [&](int idx) { return stmt.ColumnInt64(first + idx); };
+    const auto col_text = [&](int idx) { return stmt.ColumnText(first + idx); };
 
     // initialize command with query results
-    command["fil_d"]         = stmt.ColumnInt64(3);
-    command["fil_h"]         = stmt.ColumnInt64(4);
-    command["fil_w"]         = stmt.ColumnInt64(5);
-    command["pad_d"]         = stmt.ColumnInt64(6);
-    command["pad_h"]         = stmt.ColumnInt64(7);
-    command["pad_w"]         = stmt.ColumnInt64(8);
-    command["conv_stride_d"] = stmt.ColumnInt64(9);
-    command["conv_stride_h"] = stmt.ColumnInt64(10);
-    command["conv_stride_w"] = stmt.ColumnInt64(11);
-    command["dilation_d"]    = stmt.ColumnInt64(12);
-    command["dilation_h"]    = stmt.ColumnInt64(13);
-    command["dilation_w"]    = stmt.ColumnInt64(14);
-    command["spatial_dim"]   = stmt.ColumnInt64(15);
-
-    command["direction"] = stmt.ColumnText(18);
+    json command;
+    command["fil_d"]         = col_int(3);
+    command["fil_h"]         = col_int(4);
+    command["fil_w"]         = col_int(5);
+    command["pad_d"]         = col_int(6);
+    command["pad_h"]         = col_int(7);
+    command["pad_w"]         = col_int(8);
+    command["conv_stride_d"] = col_int(9);
+    command["conv_stride_h"] = col_int(10);
+    command["conv_stride_w"] = col_int(11);
+    command["dilation_d"]    = col_int(12);
+    command["dilation_h"]    = col_int(13);
+    command["dilation_w"]    = col_int(14);
+    command["spatial_dim"]   = col_int(15);
+
+    command["direction"] = col_text(18);
     if(command["direction"] == "F")
     {
-        command["out_channels"] = stmt.ColumnInt64(19);
-        command["in_channels"]  = stmt.ColumnInt64(20);
-        command["in_d"]         = stmt.ColumnInt64(0);
-        command["in_h"]         = stmt.ColumnInt64(1);
-        command["in_w"]         = stmt.ColumnInt64(2);
+        command["out_channels"] = col_int(19);
+        command["in_channels"]  = col_int(20);
+        command["in_d"]         = col_int(0);
+        command["in_h"]         = col_int(1);
+        command["in_w"]         = col_int(2);
     }
     else
     {
-        command["out_channels"] = stmt.ColumnInt64(20);
-        command["in_channels"]  = stmt.ColumnInt64(19);
-        command["in_d"] = (stmt.ColumnInt64(0) - 1) * static_cast<int>(command["conv_stride_d"]) +
+        command["out_channels"] = col_int(20);
+        command["in_channels"]  = col_int(19);
+        command["in_d"] = (col_int(0) - 1) * static_cast<int>(command["conv_stride_d"]) +
                           static_cast<int>(command["fil_d"]) -
                           2 * static_cast<int>(command["pad_d"]);
-        command["in_h"] = (stmt.ColumnInt64(1) - 1) * static_cast<int>(command["conv_stride_h"]) +
+        command["in_h"] = (col_int(1) - 1) * static_cast<int>(command["conv_stride_h"]) +
                           static_cast<int>(command["fil_h"]) -
                           2 * static_cast<int>(command["pad_h"]);
-        command["in_w"] = (stmt.ColumnInt64(2) - 1) * static_cast<int>(command["conv_stride_w"]) +
+        command["in_w"] = (col_int(2) - 1) * static_cast<int>(command["conv_stride_w"]) +
                           static_cast<int>(command["fil_w"]) -
                           2 * static_cast<int>(command["pad_w"]);
     }
 
-    command["batchsize"]   = stmt.ColumnInt64(21);
-    command["group_count"] = stmt.ColumnInt64(22);
-    command["bias"]        = stmt.ColumnInt64(23);
+    command["batchsize"]   = col_int(21);
+    command["group_count"] = col_int(22);
+    command["bias"]        = col_int(23);
     command["mode"]        = "conv";
 
-    auto layout           = stmt.ColumnText(16);
+    auto layout           = col_text(16);
     command["in_layout"]  = layout;
     command["wei_layout"] = layout;
     command["out_layout"] = layout;
-    std::string data_type = stmt.ColumnText(17);
+    command["data_type"]  = col_text(17);
 
     std::cout << "cfg (" << config_id << ") "
               << "json command: " << command.dump() << std::endl;
+    return command;
+}
+
+template <typename Tgpu, typename Tref>
+miopen::ProblemDescription ConvFin<Tgpu, Tref>::BuildConvProblem(const json& config_cmd)
+{
+    const std::string data_type = config_cmd["data_type"];
     miopen::ProblemDescription problem;
     if(data_type == "FP32")
     {
-        problem = fin::ConvFin<float, float>().GetCmdConvProblem(command);
+        problem = fin::ConvFin<float, float>().GetCmdConvProblem(config_cmd);
     }
     else if(data_type == "FP16")
     {
-        problem = fin::ConvFin<float16, float>().GetCmdConvProblem(command);
+        problem = fin::ConvFin<float16, float>().GetCmdConvProblem(config_cmd);
     }
     else if(data_type == "BF16")
     {
-        problem = fin::ConvFin<bfloat16, float>().GetCmdConvProblem(command);
+        problem = fin::ConvFin<bfloat16, float>().GetCmdConvProblem(config_cmd);
     }
     else if(data_type == "INT8")
     {
-        problem = fin::ConvFin<int8_t, float>().GetCmdConvProblem(command);
+        problem = fin::ConvFin<int8_t, float>().GetCmdConvProblem(config_cmd);
     }
     else
     {
@@ -2151,18 +2544,19 @@ bool ConvFin<Tgpu, Tref>::IsInputTensorTransform() const
 
 namespace detail {
 
+// Maps a uniform value in [0, 1) to the weights range [-0.5, 0.5)
 template <typename T>
-T RanGenWeights()
+inline float RanGenWeights(float u)
 {
-    return RAN_GEN<T>(static_cast<T>(-0.5), static_cast<T>(0.5));
+    return u - 0.5f;
 }
 
 // Shift FP16 distribution towards positive numbers,
 // otherwise Winograd FP16 validation fails.
 template <>
-float16 RanGenWeights()
+inline float RanGenWeights<float16>(float u)
 {
-    return RAN_GEN<float16>(static_cast<float16>(-1.0 / 3.0), static_cast<float16>(0.5));
+    return (u * (0.5f + 1.0f / 3.0f)) - 1.0f / 3.0f;
 }
 
 } // namespace detail
@@ -2171,18 +2565,22 @@ template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::AllocateBuffers()
 {
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to allocate buffers with NOGPU backend");
-#else
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to allocate buffers with NOGPU backend");
+#endif
     GetandSetData();
     inputTensor.AllocateBuffers();
-    inputTensor_vect4.AllocateBuffers();
     weightTensor.AllocateBuffers();
+    if(IsInputTensorTransform())
+    {
+        inputTensor_vect4.AllocateBuffers();
+        weightTensor_vect4.AllocateBuffers();
+    }
     outputTensor.AllocateBuffers();
     biasTensor.AllocateBuffers();
-    // The workspace is actually allocated when the solver is about to be run
-    // since it varies from solver to solver
-    workspace.AllocateBuffers();
-#endif
+    // The workspace grows when a solver needs more, it is shared with the
+    // jobs that follow
+    DeviceWorkspace().Reserve(workspace.desc.GetNumBytes());
     return 0;
 }
 
@@ -2248,81 +2646,97 @@ int ConvFin<Tgpu, Tref>::CalcWorkspace()
     return wsSizeof;
 }
 
+// The init helpers map element idx with uniform value u to its initial
+// value. They work on floats, the conversion to Tgpu is done in bulk.
 template <typename Tgpu>
-Tgpu init_in(bool is_int8, size_t idx)
+float init_in(bool is_int8, float u, size_t idx)
 {
     (void)idx;
     if(is_int8)
-    {
-        float Data_scale = 127.0;
-        return static_cast<Tgpu>(Data_scale *
-                                 RAN_GEN<float>(static_cast<float>(0.0), static_cast<float>(1.0)));
-    }
-    else
-    {
-        Tgpu Data_scale = static_cast<Tgpu>(0.01);
-        return Data_scale * RAN_GEN<Tgpu>(static_cast<Tgpu>(0.0), static_cast<Tgpu>(1.0));
-    }
+        return 127.0f * u;
+    return 0.01f * u;
 }
 
 template <typename Tgpu>
-Tgpu init_out(bool is_int8, size_t idx)
+float init_out(bool is_int8, float u, size_t idx)
 {
     (void)idx;
     if(is_int8)
-    {
-        return static_cast<Tgpu>(0); // int8 is inference only
-    }
-    else
-    {
-        Tgpu Data_scale = static_cast<Tgpu>(0.01);
-        return Data_scale * RAN_GEN<Tgpu>(static_cast<Tgpu>(0.0), static_cast<Tgpu>(1.0));
-    }
+        return 0.0f; // int8 is inference only
+    return 0.01f * u;
 }
 
 template <typename Tgpu>
-Tgpu init_wei(bool is_int8, size_t idx)
+float init_wei(bool is_int8, float u, size_t idx)
 {
     (void)idx;
     if(is_int8)
-    {
-        float Data_scale = 127.0;
-        return static_cast<Tgpu>(Data_scale * 2 * detail::RanGenWeights<float>());
-    }
-    else
-    {
-        Tgpu Data_scale = static_cast<Tgpu>(0.01);
-        return Data_scale * detail::RanGenWeights<Tgpu>();
-    }
+        return 127.0f * 2 * detail::RanGenWeights<float>(u);
+    return 0.01f * detail::RanGenWeights<Tgpu>(u);
 }
 
 template <typename Tgpu>
-Tgpu init_bias(bool is_int8, size_t idx)
+float init_bias(bool is_int8, float u, size_t idx)
 {
-    (void)idx;
     (void)is_int8;
-    return static_cast<Tgpu>(idx % 8) +
-           RAN_GEN<Tgpu>(static_cast<Tgpu>(0.0), static_cast<Tgpu>(1.0));
+    return static_cast<float>(idx % 8) + u;
 }
 
 template <typename Tgpu, typename Tref>
 int ConvFin<Tgpu, Tref>::FillBuffers()
 {
 #if MIOPEN_MODE_NOGPU
-    throw std::runtime_error("Unable to fill buffers with NOGPU backend");
-#else
+    if(!DeviceAllocator()->IsHost())
+        throw std::runtime_error("Unable to fill buffers with NOGPU backend");
+#endif
     // TODO: Do we need to initialized tensors ?
     auto is_int8 = (data_type == miopenInt8);
-    srand(0);
+    // Every tensor draws from its own stream of a counter based generator, so
+    // the data only depends on the seed and not on the number of threads.
+    // With "reuse_filled_data" the data of an earlier job with the same
+    // descriptor and seed is taken over instead of being filled again.
+    const auto seed        = job.value("seed", uint64_t{0});
+    const auto reuse       = job.value("reuse_filled_data", false);
+    const auto num_threads = GetNumThreads(job);
+    const auto fill        = [&](auto& t, auto init, uint32_t stream) {
+        const auto key = reuse ? t.GetFillKey(seed, stream) : std::string{};
+        if(reuse && t.TakeFilledData(key))
+            return;
+        const CounterRng rng{seed, stream};
+        t.FillBuffer(rng, [&](float u, size_t idx) { return init(is_int8, u, idx); }, num_threads);
+        if(reuse && t.is_input)
+            t.fill_key = key;
+    };
 
-    inputTensor.FillBuffer(std::bind(init_in<Tgpu>, is_int8, std::placeholders::_1));
-    outputTensor.FillBuffer(std::bind(init_out<Tgpu>, is_int8, std::placeholders::_1));
-    weightTensor.FillBuffer(std::bind(init_wei<Tgpu>, is_int8, std::placeholders::_1));
+    fill(inputTensor, init_in<Tgpu>, 0);
+    fill(outputTensor, init_out<Tgpu>, 1);
+    fill(weightTensor, init_wei<Tgpu>, 2);
     if(command["bias"].get<int>() != 0)
     {
-        biasTensor.FillBuffer(std::bind(init_bias<Tgpu>, is_int8, std::placeholders::_1));
+        fill(biasTensor, init_bias<Tgpu>, 3);
+    }
+
+    // int8 kernels need the channels padded to a multiple of four, the
+    // padded copies hold the same data as the NCHW input and weights
+    if(IsInputTensorTransform())
+    {
+        const auto pad = [&](const auto& src, auto& dst) {
+            if(!src.is_input)
+                return;
+            const auto& lens = src.desc.GetLengths();
+            const size_t s   = std::accumulate(
+                lens.begin() + 2, lens.end(), size_t{1}, std::multiplies<size_t>{});
+            PadChannels(src.cpuData.data(),
+                        dst.cpuData.data(),
+                        lens[0],
+                        lens[1],
+                        dst.desc.GetLengths()[1],
+                        s,
+                        num_threads);
+        };
+        pad(inputTensor, inputTensor_vect4);
+        pad(weightTensor, weightTensor_vect4);
     }
-#endif
     return 0;
 }
 } // namespace fin
@@ -0,0 +1,327 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_CPU_BN_HPP
+#define GUARD_FIN_CPU_BN_HPP
+
+#include "cpu_tensor.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace fin {
+
+// Host reference batch normalization on N, C, D, H, W views with the
+// semantics of the MIOpen batch norm API. Parameter tensors (scale, bias,
+// means and variances) are 1 x C x 1 x 1 x 1 in spatial mode and
+// 1 x C x D x H x W in per activation mode. Every channel is one task.
+
+enum class CpuBnMode
+{
+    PerActivation,
+    Spatial,
+};
+
+// Running mean and sum of squared deviations. Merge combines the
+// statistics of two disjoint sets (Chan et al.).
+struct WelfordStats
+{
+    double count = 0.0;
+    double mean  = 0.0;
+    double m2    = 0.0;
+
+    void Add(double v)
+    {
+        count += 1.0;
+        const double delta = v - mean;
+        mean += delta / count;
+        m2 += delta * (v - mean);
+    }
+
+    void Merge(const WelfordStats& other)
+    {
+        if(other.count == 0.0)
+            return;
+        const double total = count + other.count;
+        const double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * count * other.count / total;
+        count = total;
+    }
+
+    // population variance, as used for normalization
+    double Variance() const { return count > 0.0 ? m2 / count : 0.0; }
+};
+
+namespace detail {
+
+inline void CheckBnViews(CpuBnMode mode,
+                         const std::array<size_t, 5>& x,
+                         const std::array<size_t, 5>& param)
+{
+    const bool spatial = mode == CpuBnMode::Spatial;
+    if(param[0] != 1 || param[1] != x[1])
+        throw std::runtime_error("Batch norm parameter tensor does not match the input");
+    for(size_t dim = 2; dim < 5; dim++)
+        if(param[dim] != (spatial ? 1 : x[dim]))
+            throw std::runtime_error("Batch norm parameter tensor does not match the mode");
+}
+
+// Calls f(n, d, h, w) for every element of channel c, innermost over w
+template <typename F>
+void ForEachInChannel(const std::array<size_t, 5>& lens, F f)
+{
+    for(size_t n = 0; n < lens[0]; n++)
+        for(size_t d = 0; d < lens[2]; d++)
+            for(size_t h = 0; h < lens[3]; h++)
+                for(size_t w = 0; w < lens[4]; w++)
+                    f(n, d, h, w);
+}
+
+// Index of the statistics slot of an element within its channel
+inline size_t
+BnSlot(CpuBnMode mode, const std::array<size_t, 5>& lens, size_t d, size_t h, size_t w)
+{
+    return mode == CpuBnMode::Spatial ? 0 : (d * lens[3] + h) * lens[4] + w;
+}
+
+inline size_t BnSlots(CpuBnMode mode, const std::array<size_t, 5>& lens)
+{
+    return mode == CpuBnMode::Spatial ? 1 : lens[2] * lens[3] * lens[4];
+}
+
+// Calls f(slot, d, h, w) once per statistics slot
+template <typename F>
+void ForEachBnSlot(CpuBnMode mode, const std::array<size_t, 5>& lens, F f)
+{
+    if(mode == CpuBnMode::Spatial)
+    {
+        f(size_t{0}, size_t{0}, size_t{0}, size_t{0});
+        return;
+    }
+    ForEachInChannel({1, lens[1], lens[2], lens[3], lens[4]},
+                     [&](size_t, size_t d, size_t h, size_t w) {
+                         f(BnSlot(mode, lens, d, h, w), d, h, w);
+                     });
+}
+
+template <typename T>
+T& BnParam(CpuBnMode mode, const CpuTensorView<T>& p, size_t c, size_t d, size_t h, size_t w)
+{
+    return mode == CpuBnMode::Spatial ? p(0, c, 0, 0, 0) : p(0, c, d, h, w);
+}
+
+// One pass Welford statistics of channel c. In spatial mode the
+// reduction is spread over independent lanes along w, which keeps the
+// dependency chains short, and the lanes are merged at the end.
+template <typename Tx>
+std::vector<WelfordStats> BnChannelStats(CpuBnMode mode, const CpuTensorView<Tx>& x, size_t c)
+{
+    constexpr size_t lanes = 8;
+    std::vector<WelfordStats> stats(mode == CpuBnMode::Spatial ? lanes : BnSlots(mode, x.lens));
+    ForEachInChannel(x.lens, [&](size_t n, size_t d, size_t h, size_t w) {
+        const size_t slot = mode == CpuBnMode::Spatial ? w % lanes : BnSlot(mode, x.lens, d, h, w);
+        stats[slot].Add(ToDouble(x(n, c, d, h, w)));
+    });
+    if(mode == CpuBnMode::Spatial)
+    {
+        for(size_t lane = 1; lane < lanes; lane++)
+            stats[0].Merge(stats[lane]);
+        stats.resize(1);
+    }
+    return stats;
+}
+
+} // namespace detail
+
+// y = scale * (x - est_mean) / sqrt(est_var + epsilon) + bias
+template <typename Tx, typename Tp, typename Ty>
+void BnFwdInferCpu(CpuBnMode mode,
+                   double epsilon,
+                   const CpuTensorView<Tx>& x,
+                   const CpuTensorView<Tp>& scale,
+                   const CpuTensorView<Tp>& bias,
+                   const CpuTensorView<Tp>& est_mean,
+                   const CpuTensorView<Tp>& est_var,
+                   const CpuTensorView<Ty>& y,
+                   size_t num_threads)
+{
+    detail::CheckBnViews(mode, x.lens, scale.lens);
+    ParallelFor(x.lens[1], num_threads, [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; c++)
+        {
+            detail::ForEachInChannel(x.lens, [&](size_t n, size_t d, size_t h, size_t w) {
+                const auto param = [&](const CpuTensorView<Tp>& p) {
+                    return detail::ToDouble(detail::BnParam(mode, p, c, d, h, w));
+                };
+                const double inv_std = 1.0 / std::sqrt(param(est_var) + epsilon);
+                const double diff    = detail::ToDouble(x(n, c, d, h, w)) - param(est_mean);
+                y(n, c, d, h, w)     = static_cast<Ty>(param(scale) * diff * inv_std + param(bias));
+            });
+        }
+    });
+}
+
+// Training forward pass. Normalizes with the batch statistics and, when
+// the views are given (data != nullptr), updates the running mean and
+// unbiased variance with exp_avg_factor and saves the batch mean and
+// inverse standard deviation for the backward pass.
+template <typename Tx, typename Tp, typename Ty>
+void BnFwdTrainCpu(CpuBnMode mode,
+                   double epsilon,
+                   double exp_avg_factor,
+                   const CpuTensorView<Tx>& x,
+                   const CpuTensorView<Tp>& scale,
+                   const CpuTensorView<Tp>& bias,
+                   const CpuTensorView<Ty>& y,
+                   const CpuTensorView<Tp>& running_mean,
+                   const CpuTensorView<Tp>& running_var,
+                   const CpuTensorView<Tp>& saved_mean,
+                   const CpuTensorView<Tp>& saved_inv_var,
+                   size_t num_threads)
+{
+    detail::CheckBnViews(mode, x.lens, scale.lens);
+    ParallelFor(x.lens[1], num_threads, [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; c++)
+        {
+            const auto stats = detail::BnChannelStats(mode, x, c);
+            std::vector<double> inv_std(stats.size());
+            for(size_t slot = 0; slot < stats.size(); slot++)
+                inv_std[slot] = 1.0 / std::sqrt(stats[slot].Variance() + epsilon);
+
+            detail::ForEachInChannel(x.lens, [&](size_t n, size_t d, size_t h, size_t w) {
+                const size_t slot = detail::BnSlot(mode, x.lens, d, h, w);
+                const double xhat =
+                    (detail::ToDouble(x(n, c, d, h, w)) - stats[slot].mean) * inv_std[slot];
+                const double s = detail::ToDouble(detail::BnParam(mode, scale, c, d, h, w));
+                const double b = detail::ToDouble(detail::BnParam(mode, bias, c, d, h, w));
+                y(n, c, d, h, w) = static_cast<Ty>(s * xhat + b);
+            });
+
+            detail::ForEachBnSlot(mode, x.lens, [&](size_t slot, size_t d, size_t h, size_t w) {
+                const auto& st = stats[slot];
+                const double f = exp_avg_factor;
+                if(running_mean.data != nullptr)
+                {
+                    auto& mean = detail::BnParam(mode, running_mean, c, d, h, w);
+                    mean = static_cast<Tp>((1.0 - f) * detail::ToDouble(mean) + f * st.mean);
+                }
+                if(running_var.data != nullptr)
+                {
+                    const double adjust = st.count > 1.0 ? st.count / (st.count - 1.0) : 1.0;
+                    auto& var           = detail::BnParam(mode, running_var, c, d, h, w);
+                    var = static_cast<Tp>((1.0 - f) * detail::ToDouble(var) +
+                                          f * adjust * st.Variance());
+                }
+                if(saved_mean.data != nullptr)
+                    detail::BnParam(mode, saved_mean, c, d, h, w) = static_cast<Tp>(st.mean);
+                if(saved_inv_var.data != nullptr)
+                    detail::BnParam(mode, saved_inv_var, c, d, h, w) =
+                        static_cast<Tp>(inv_std[slot]);
+            });
+        }
+    });
+}
+
+// Backward pass with respect to x, scale and bias. Uses the saved batch
+// mean and inverse standard deviation when given, otherwise recomputes
+// them from x.
+template <typename Tx, typename Tp, typename Ty>
+void BnBwdCpu(CpuBnMode mode,
+              double epsilon,
+              const CpuTensorView<Tx>& x,
+              const CpuTensorView<Tx>& dy,
+              const CpuTensorView<Tp>& scale,
+              const CpuTensorView<Tp>& saved_mean,
+              const CpuTensorView<Tp>& saved_inv_var,
+              const CpuTensorView<Ty>& dx,
+              const CpuTensorView<Tp>& dscale,
+              const CpuTensorView<Tp>& dbias,
+              size_t num_threads)
+{
+    detail::CheckBnViews(mode, x.lens, scale.lens);
+    const bool use_saved = saved_mean.data != nullptr && saved_inv_var.data != nullptr;
+    ParallelFor(x.lens[1], num_threads, [&](size_t begin, size_t end) {
+        for(size_t c = begin; c < end; c++)
+        {
+            const size_t slots = detail::BnSlots(mode, x.lens);
+            std::vector<double> mean(slots);
+            std::vector<double> inv_std(slots);
+            if(use_saved)
+            {
+                detail::ForEachBnSlot(mode, x.lens, [&](size_t slot, size_t d, size_t h, size_t w) {
+                    mean[slot] = detail::ToDouble(detail::BnParam(mode, saved_mean, c, d, h, w));
+                    inv_std[slot] =
+                        detail::ToDouble(detail::BnParam(mode, saved_inv_var, c, d, h, w));
+                });
+            }
+            else
+            {
+                const auto stats = detail::BnChannelStats(mode, x, c);
+                for(size_t slot = 0; slot < slots; slot++)
+                {
+                    mean[slot]    = stats[slot].mean;
+                    inv_std[slot] = 1.0 / std::sqrt(stats[slot].Variance() + epsilon);
+                }
+            }
+
+            // xhat = (x - mean) * inv_std
+            // dx = scale * inv_std / count * (count * dy - sum(dy) - xhat * sum(dy * xhat))
+            const auto xhat = [&](size_t n, size_t slot, size_t d, size_t h, size_t w) {
+                return (detail::ToDouble(x(n, c, d, h, w)) - mean[slot]) * inv_std[slot];
+            };
+            std::vector<double> sum_dy(slots);
+            std::vector<double> sum_dy_xhat(slots);
+            detail::ForEachInChannel(x.lens, [&](size_t n, size_t d, size_t h, size_t w) {
+                const size_t slot = detail::BnSlot(mode, x.lens, d, h, w);
+                const double g    = detail::ToDouble(dy(n, c, d, h, w));
+                sum_dy[slot] += g;
+                sum_dy_xhat[slot] += g * xhat(n, slot, d, h, w);
+            });
+
+            const double count = static_cast<double>(x.ElementSize() / x.lens[1] / slots);
+            detail::ForEachInChannel(x.lens, [&](size_t n, size_t d, size_t h, size_t w) {
+                const size_t slot = detail::BnSlot(mode, x.lens, d, h, w);
+                const double g    = detail::ToDouble(dy(n, c, d, h, w));
+                const double s    = detail::ToDouble(detail::BnParam(mode, scale, c, d, h, w));
+                const double diff =
+                    count * g - sum_dy[slot] - xhat(n, slot, d, h, w) * sum_dy_xhat[slot];
+                dx(n, c, d, h, w) = static_cast<Ty>(s * inv_std[slot] / count * diff);
+            });
+
+            detail::ForEachBnSlot(mode, x.lens, [&](size_t slot, size_t d, size_t h, size_t w) {
+                detail::BnParam(mode, dbias, c, d, h, w)  = static_cast<Tp>(sum_dy[slot]);
+                detail::BnParam(mode, dscale, c, d, h, w) = static_cast<Tp>(sum_dy_xhat[slot]);
+            });
+        }
+    });
+}
+
+} // namespace fin
+#endif // GUARD_FIN_CPU_BN_HPP
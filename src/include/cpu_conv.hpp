@@ -0,0 +1,308 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_CPU_CONV_HPP
+#define GUARD_FIN_CPU_CONV_HPP
+
+#include "cpu_tensor.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace fin {
+
+// Convolution geometry in the forward sense: x is N x (G*C) x Di x Hi x Wi,
+// w is (G*K) x C x Z x Y x X and y is N x (G*K) x Do x Ho x Wo. Spatial
+// parameters are in D, H, W order.
+struct CpuConvProblem
+{
+    size_t groups = 1;
+    std::array<int, 3> pads{};
+    std::array<int, 3> strides{1, 1, 1};
+    std::array<int, 3> dilations{1, 1, 1};
+};
+
+namespace detail {
+
+// One filter tap (fz, fy, fx) together with the range of output positions
+// it contributes to. Along each spatial dim the input position of output
+// position o is o * stride + offset, with offset = f * dilation - pad.
+struct FilterTap
+{
+    std::array<size_t, 3> f;
+    std::array<long long, 3> offset;
+    std::array<size_t, 3> begin;
+    std::array<size_t, 3> end;
+
+    size_t In(size_t dim, size_t o, const std::array<int, 3>& strides) const
+    {
+        return static_cast<size_t>(static_cast<long long>(o) * strides[dim] + offset[dim]);
+    }
+};
+
+inline std::vector<FilterTap> GetFilterTaps(const CpuConvProblem& problem,
+                                            const std::array<size_t, 5>& x_lens,
+                                            const std::array<size_t, 5>& w_lens,
+                                            const std::array<size_t, 5>& y_lens)
+{
+    std::vector<FilterTap> taps;
+    taps.reserve(w_lens[2] * w_lens[3] * w_lens[4]);
+    for(size_t fz = 0; fz < w_lens[2]; fz++)
+        for(size_t fy = 0; fy < w_lens[3]; fy++)
+            for(size_t fx = 0; fx < w_lens[4]; fx++)
+            {
+                FilterTap tap{{fz, fy, fx}, {}, {}, {}};
+                for(size_t dim = 0; dim < 3; dim++)
+                {
+                    const long long stride  = problem.strides[dim];
+                    const long long out_len = y_lens[2 + dim];
+                    const long long in_len  = x_lens[2 + dim];
+                    tap.offset[dim] =
+                        static_cast<long long>(tap.f[dim]) * problem.dilations[dim] -
+                        problem.pads[dim];
+                    // o * stride + offset in [0, in_len)
+                    const long long lo  = tap.offset[dim] >= 0
+                                              ? 0
+                                              : (stride - 1 - tap.offset[dim]) / stride;
+                    const long long top = in_len - 1 - tap.offset[dim];
+                    const long long hi  = top < 0 ? 0 : top / stride + 1;
+                    tap.begin[dim]      = static_cast<size_t>(std::min(lo, out_len));
+                    tap.end[dim] = static_cast<size_t>(std::min(std::max(hi, lo), out_len));
+                }
+                taps.push_back(tap);
+            }
+    return taps;
+}
+
+inline void CheckConvViews(const std::array<size_t, 5>& x,
+                           const std::array<size_t, 5>& w,
+                           const std::array<size_t, 5>& y,
+                           const CpuConvProblem& problem)
+{
+    if(problem.groups == 0 || x[0] != y[0] || x[1] != w[1] * problem.groups ||
+       y[1] != w[0] || w[0] % problem.groups != 0)
+        throw std::runtime_error("Inconsistent tensor lengths for the CPU convolution");
+}
+
+} // namespace detail
+
+// y = conv(x, w). Every (n, k) output plane is computed by one task, it
+// accumulates in a dense double buffer row by row so the innermost loop
+// walks contiguous memory and the plane stays in cache.
+template <typename Tx, typename Tw, typename Ty>
+void ConvFwdCpu(const CpuConvProblem& problem,
+                const CpuTensorView<Tx>& x,
+                const CpuTensorView<Tw>& w,
+                const CpuTensorView<Ty>& y,
+                size_t num_threads)
+{
+    detail::CheckConvViews(x.lens, w.lens, y.lens, problem);
+    const auto taps      = detail::GetFilterTaps(problem, x.lens, w.lens, y.lens);
+    const auto& st       = problem.strides;
+    const size_t k_per_g = w.lens[0] / problem.groups;
+    const size_t c_per_g = w.lens[1];
+
+    ParallelFor(y.lens[0] * y.lens[1], num_threads, [&](size_t begin, size_t end) {
+        std::vector<double> acc(y.lens[2] * y.lens[3] * y.lens[4]);
+        for(size_t task = begin; task < end; task++)
+        {
+            const size_t n = task / y.lens[1];
+            const size_t k = task % y.lens[1];
+            std::fill(acc.begin(), acc.end(), 0.0);
+            for(size_t c = 0; c < c_per_g; c++)
+            {
+                const size_t xc = (k / k_per_g) * c_per_g + c;
+                for(const auto& tap : taps)
+                {
+                    const double wv = detail::ToDouble(w(k, c, tap.f[0], tap.f[1], tap.f[2]));
+                    for(size_t oz = tap.begin[0]; oz < tap.end[0]; oz++)
+                    {
+                        for(size_t oy = tap.begin[1]; oy < tap.end[1]; oy++)
+                        {
+                            double* row = acc.data() + (oz * y.lens[3] + oy) * y.lens[4];
+                            const auto* xrow = &x(n, xc, tap.In(0, oz, st), tap.In(1, oy, st), 0);
+                            for(size_t ox = tap.begin[2]; ox < tap.end[2]; ox++)
+                                row[ox] += wv * detail::ToDouble(
+                                                    xrow[tap.In(2, ox, st) * x.strides[4]]);
+                        }
+                    }
+                }
+            }
+            size_t idx = 0;
+            for(size_t oz = 0; oz < y.lens[2]; oz++)
+                for(size_t oy = 0; oy < y.lens[3]; oy++)
+                    for(size_t ox = 0; ox < y.lens[4]; ox++)
+                        y(n, k, oz, oy, ox) = static_cast<Ty>(acc[idx++]);
+        }
+    });
+}
+
+// dx = conv_bwd_data(dy, w), the adjoint of ConvFwdCpu with respect to x.
+// Every (n, c) input gradient plane is owned by one task, which scatters
+// the contributions of all output positions into its dense buffer.
+template <typename Tdy, typename Tw, typename Tdx>
+void ConvBwdDataCpu(const CpuConvProblem& problem,
+                    const CpuTensorView<Tdy>& dy,
+                    const CpuTensorView<Tw>& w,
+                    const CpuTensorView<Tdx>& dx,
+                    size_t num_threads)
+{
+    detail::CheckConvViews(dx.lens, w.lens, dy.lens, problem);
+    const auto taps      = detail::GetFilterTaps(problem, dx.lens, w.lens, dy.lens);
+    const auto& st       = problem.strides;
+    const size_t k_per_g = w.lens[0] / problem.groups;
+    const size_t c_per_g = w.lens[1];
+
+    ParallelFor(dx.lens[0] * dx.lens[1], num_threads, [&](size_t begin, size_t end) {
+        std::vector<double> acc(dx.lens[2] * dx.lens[3] * dx.lens[4]);
+        for(size_t task = begin; task < end; task++)
+        {
+            const size_t n  = task / dx.lens[1];
+            const size_t xc = task % dx.lens[1];
+            const size_t c  = xc % c_per_g;
+            std::fill(acc.begin(), acc.end(), 0.0);
+            for(size_t kk = 0; kk < k_per_g; kk++)
+            {
+                const size_t k = (xc / c_per_g) * k_per_g + kk;
+                for(const auto& tap : taps)
+                {
+                    const double wv = detail::ToDouble(w(k, c, tap.f[0], tap.f[1], tap.f[2]));
+                    for(size_t oz = tap.begin[0]; oz < tap.end[0]; oz++)
+                    {
+                        for(size_t oy = tap.begin[1]; oy < tap.end[1]; oy++)
+                        {
+                            const size_t iz = tap.In(0, oz, st);
+                            const size_t iy = tap.In(1, oy, st);
+                            double* row     = acc.data() + (iz * dx.lens[3] + iy) * dx.lens[4];
+                            const auto* dyrow = &dy(n, k, oz, oy, 0);
+                            for(size_t ox = tap.begin[2]; ox < tap.end[2]; ox++)
+                                row[tap.In(2, ox, st)] +=
+                                    wv * detail::ToDouble(dyrow[ox * dy.strides[4]]);
+                        }
+                    }
+                }
+            }
+            size_t idx = 0;
+            for(size_t iz = 0; iz < dx.lens[2]; iz++)
+                for(size_t iy = 0; iy < dx.lens[3]; iy++)
+                    for(size_t ix = 0; ix < dx.lens[4]; ix++)
+                        dx(n, xc, iz, iy, ix) = static_cast<Tdx>(acc[idx++]);
+        }
+    });
+}
+
+// dw = conv_bwd_weights(x, dy). Every (k, c) filter is computed by one task
+// as a dot product of the shifted input and the output gradient per tap.
+template <typename Tx, typename Tdy, typename Tdw>
+void ConvWrwCpu(const CpuConvProblem& problem,
+                const CpuTensorView<Tx>& x,
+                const CpuTensorView<Tdy>& dy,
+                const CpuTensorView<Tdw>& dw,
+                size_t num_threads)
+{
+    detail::CheckConvViews(x.lens, dw.lens, dy.lens, problem);
+    const auto taps      = detail::GetFilterTaps(problem, x.lens, dw.lens, dy.lens);
+    const auto& st       = problem.strides;
+    const size_t k_per_g = dw.lens[0] / problem.groups;
+    const size_t c_per_g = dw.lens[1];
+
+    ParallelFor(dw.lens[0] * c_per_g, num_threads, [&](size_t begin, size_t end) {
+        for(size_t task = begin; task < end; task++)
+        {
+            const size_t k  = task / c_per_g;
+            const size_t c  = task % c_per_g;
+            const size_t xc = (k / k_per_g) * c_per_g + c;
+            for(const auto& tap : taps)
+            {
+                double sum = 0.0;
+                for(size_t n = 0; n < x.lens[0]; n++)
+                {
+                    for(size_t oz = tap.begin[0]; oz < tap.end[0]; oz++)
+                    {
+                        for(size_t oy = tap.begin[1]; oy < tap.end[1]; oy++)
+                        {
+                            const auto* xrow  = &x(n, xc, tap.In(0, oz, st), tap.In(1, oy, st), 0);
+                            const auto* dyrow = &dy(n, k, oz, oy, 0);
+                            for(size_t ox = tap.begin[2]; ox < tap.end[2]; ox++)
+                                sum += detail::ToDouble(xrow[tap.In(2, ox, st) * x.strides[4]]) *
+                                       detail::ToDouble(dyrow[ox * dy.strides[4]]);
+                        }
+                    }
+                }
+                dw(k, c, tap.f[0], tap.f[1], tap.f[2]) = static_cast<Tdw>(sum);
+            }
+        }
+    });
+}
+
+struct VerifyStats
+{
+    double rms           = 0.0;
+    double max_abs_error = 0.0;
+    size_t num_nans      = 0;
+};
+
+// Relative RMS error as computed by the MIOpen driver:
+// sqrt(sum((a - b)^2)) / (sqrt(n) * max(max|a|, max|b|))
+template <typename T, typename Tref>
+VerifyStats CompareToReference(const CpuTensorView<T>& out, const CpuTensorView<Tref>& ref)
+{
+    if(out.lens != ref.lens)
+        throw std::runtime_error("Reference and result tensors differ in size");
+    VerifyStats stats;
+    double sum_sq  = 0.0;
+    double max_mag = 0.0;
+    for(size_t n = 0; n < out.lens[0]; n++)
+        for(size_t c = 0; c < out.lens[1]; c++)
+            for(size_t d = 0; d < out.lens[2]; d++)
+                for(size_t h = 0; h < out.lens[3]; h++)
+                    for(size_t w = 0; w < out.lens[4]; w++)
+                    {
+                        const double a = detail::ToDouble(out(n, c, d, h, w));
+                        const double b = detail::ToDouble(ref(n, c, d, h, w));
+                        if(std::isnan(a))
+                        {
+                            stats.num_nans++;
+                            continue;
+                        }
+                        const double err    = std::abs(a - b);
+                        sum_sq += err * err;
+                        stats.max_abs_error = std::max(stats.max_abs_error, err);
+                        max_mag             = std::max({max_mag, std::abs(a), std::abs(b)});
+                    }
+    const double size = static_cast<double>(out.ElementSize());
+    if(max_mag > 0.0 && size > 0.0)
+        stats.rms = std::sqrt(sum_sq) / (std::sqrt(size) * max_mag);
+    return stats;
+}
+
+} // namespace fin
+#endif // GUARD_FIN_CPU_CONV_HPP
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_CPU_TENSOR_HPP
+#define GUARD_FIN_CPU_TENSOR_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace fin {
+
+// Strided view of a tensor in N, C, D, H, W order. 2D tensors use a depth
+// of one, the strides may describe any memory layout.
+template <typename T>
+struct CpuTensorView
+{
+    T* data = nullptr;
+    std::array<size_t, 5> lens{};
+    std::array<size_t, 5> strides{};
+
+    T& operator()(size_t n, size_t c, size_t d, size_t h, size_t w) const
+    {
+        return data[n * strides[0] + c * strides[1] + d * strides[2] + h * strides[3] +
+                    w * strides[4]];
+    }
+
+    size_t ElementSize() const
+    {
+        size_t size = 1;
+        for(auto len : lens)
+            size *= len;
+        return size;
+    }
+};
+
+// Dense N, C, D, H, W strides for the given lengths
+inline std::array<size_t, 5> PackedStrides(const std::array<size_t, 5>& lens)
+{
+    std::array<size_t, 5> strides{};
+    size_t stride = 1;
+    for(size_t dim = lens.size(); dim-- > 0;)
+    {
+        strides[dim] = stride;
+        stride *= lens[dim];
+    }
+    return strides;
+}
+
+namespace detail {
+
+// Host reference code accumulates in double, fp16 and bf16 convert through
+// float
+template <typename T>
+double ToDouble(const T& v)
+{
+    return static_cast<double>(static_cast<float>(v));
+}
+
+inline double ToDouble(double v) { return v; }
+
+} // namespace detail
+
+} // namespace fin
+#endif // GUARD_FIN_CPU_TENSOR_HPP
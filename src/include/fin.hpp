@@ -30,14 +30,23 @@
 // using float16 = half_float::half;
 #include "config.h"
 #include "tensor.hpp"
+#include "allocator.hpp"
 #include "base64.hpp"
+#include "benchmark.hpp"
+#include "blob_store.hpp"
+#include "kernel_dedup.hpp"
+#include "thread_pool.hpp"
 
 #include <nlohmann/json.hpp>
+#include <boost/filesystem.hpp>
+
 #include <algorithm>
+#include <atomic>
 #include <cfloat>
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <miopen/kernel_cache.hpp>
 #include <miopen/handle.hpp>
 #include <miopen/nogpu/handle_impl.hpp>
@@ -67,6 +76,98 @@ namespace fin {
 
 const int INVOKE_LIMIT = 4;
 
+// Sums the kernel times recorded by a handle with profiling enabled
+class HandleKernelTimer
+{
+    public:
+    explicit HandleKernelTimer(const miopen::Handle& _h) : h(_h) {}
+    void Start() { total = 0; }
+    void Lap() { total += h.GetKernelTime(); }
+    float Stop() const { return total; }
+
+    private:
+    const miopen::Handle& h;
+    float total = 0;
+};
+
+#if FIN_BACKEND_HIP
+// Times a batch of invocations on the stream of a handle with a pair of
+// events and a single sync. Profiling is turned off for the batch, since it
+// syncs after every kernel.
+class HipEventTimer
+{
+    public:
+    explicit HipEventTimer(const miopen::Handle& _h) : h(_h)
+    {
+        if(hipEventCreate(&start) != hipSuccess || hipEventCreate(&stop) != hipSuccess)
+            throw std::runtime_error("Unable to create timing events");
+    }
+    HipEventTimer(const HipEventTimer&) = delete;
+    HipEventTimer& operator=(const HipEventTimer&) = delete;
+    ~HipEventTimer()
+    {
+        std::ignore = hipEventDestroy(start);
+        std::ignore = hipEventDestroy(stop);
+    }
+    void Start()
+    {
+        h.EnableProfiling(false);
+        std::ignore = hipEventRecord(start, h.GetStream());
+    }
+    void Lap() {}
+    float Stop()
+    {
+        std::ignore = hipEventRecord(stop, h.GetStream());
+        std::ignore = hipEventSynchronize(stop);
+        h.EnableProfiling(true);
+        float ms = 0;
+        if(hipEventElapsedTime(&ms, start, stop) != hipSuccess)
+            throw std::runtime_error("Unable to read timing events");
+        return ms;
+    }
+
+    private:
+    const miopen::Handle& h;
+    hipEvent_t start = nullptr;
+    hipEvent_t stop  = nullptr;
+};
+#endif
+
+// Points the MIOpen user perf db and kernel cache at a directory of its own
+// while the object lives, so binaries and tuning results of earlier runs are
+// not picked up and the directories of the user are left alone. It has to be
+// created before MIOpen first looks the paths up. Paths the caller set in
+// the environment are kept.
+class ScopedUserCache
+{
+    public:
+    ScopedUserCache()
+    {
+        namespace fs = boost::filesystem;
+        boost::system::error_code ec;
+        const auto path = fs::temp_directory_path(ec) / fs::unique_path("fin-%%%%-%%%%-%%%%");
+        if(ec || !fs::create_directories(path, ec))
+        {
+            std::cerr << "Unable to create a MIOpen user cache: " << ec.message() << std::endl;
+            return;
+        }
+        dir = path;
+        setenv("MIOPEN_USER_DB_PATH", dir.c_str(), 0);
+        setenv("MIOPEN_CUSTOM_CACHE_DIR", dir.c_str(), 0);
+    }
+    ScopedUserCache(const ScopedUserCache&) = delete;
+    ScopedUserCache& operator=(const ScopedUserCache&) = delete;
+    ~ScopedUserCache()
+    {
+        boost::system::error_code ec;
+        if(!dir.empty())
+            boost::filesystem::remove_all(dir, ec);
+    }
+
+    private:
+    boost::filesystem::path dir;
+};
+
 class BaseFin
 {
     public:
@@ -74,9 +175,10 @@ class BaseFin
     virtual ~BaseFin() {}
     void Usage();
     std::string ParseBaseArg(const int argc, const char* argv[]);
+    // one handle per thread, so that jobs running concurrently do not share it
     miopen::Handle& GetHandle()
     {
-        static auto handle = miopen::Handle{};
+        static thread_local auto handle = miopen::Handle{};
         return handle;
     }
     miopenDataType_t GetDataType() { return data_type; }
@@ -92,6 +194,22 @@ class BaseFin
     InitNoGpuHandle(miopen::Handle& handle, const std::string& arch, const unsigned long num_cu);
     void VerifyDevProps(const std::string& in_arch, const unsigned long in_num_cu);
 
+    // Process wide number of worker threads a step may use, steps run
+    // serially unless --threads asks for more
+    static std::atomic<size_t>& DefaultNumThreads()
+    {
+        static std::atomic<size_t> num_threads{1};
+        return num_threads;
+    }
+
+    // "num_threads" in the job overrides the process wide default
+    static size_t GetNumThreads(const json& job)
+    {
+        if(job.contains("num_threads"))
+            return std::max<size_t>(job["num_threads"].get<size_t>(), 1);
+        return DefaultNumThreads();
+    }
+
     json output;
 
     int GetSolverList()
@@ -129,62 +247,321 @@ class BaseFin
         return 0;
     }
 
-    json BuildJsonKernelList(const miopen::Handle& handle,
-                             const std::vector<miopen::solver::KernelInfo>& kernels)
+    // Get the code object of a kernel, from the binary cache if it was
+    // already compiled, otherwise by building it through the handle. The
+    // mutex must be given when the handle is shared with other threads, the
+    // cache lookup then also waits for PrecompileKernels on the handle so it
+    // never sees a binary that is still being saved. Handles of different
+    // threads go to the kernel cache db on their own, which MIOpen guards
+    // with the lock file of the db.
+    std::string LoadKernelBinary(const miopen::Handle& handle,
+                                 const miopen::solver::KernelInfo& kern,
+                                 std::mutex* mtx = nullptr)
     {
-        // Get the binary
-        json kernel_list = json::array();
-        for(const auto& kern : kernels)
+        std::string comp_opts = kern.comp_options;
+        if(!miopen::EndsWith(kern.kernel_file, ".mlir"))
         {
-            json kernel;
+            comp_opts += " -mcpu=" + handle.GetDeviceName();
+        }
+        std::unique_lock<std::mutex> lock;
+        if(mtx != nullptr)
+            lock = std::unique_lock<std::mutex>(*mtx);
+        auto hsaco = miopen::LoadBinary(handle.GetTargetProperties(),
+                                        handle.GetMaxComputeUnits(),
+                                        kern.kernel_file,
+                                        comp_opts,
+                                        false);
 
-            std::string comp_opts = kern.comp_options;
-            if(!miopen::EndsWith(kern.kernel_file, ".mlir"))
+        if(hsaco.empty())
+        {
+            auto p = handle.LoadProgram(kern.kernel_file, kern.comp_options, false, "");
+            hsaco  = p.IsCodeObjectInMemory()
+                         ? p.GetCodeObjectBlob()
+                         : miopen::LoadFile(p.GetCodeObjectPathname().string());
+            if(hsaco.empty())
             {
-                comp_opts += " -mcpu=" + handle.GetDeviceName();
+                std::cerr << "Got empty code object" << std::endl;
+                throw std::runtime_error("Got empty code object");
             }
-            auto hsaco = miopen::LoadBinary(handle.GetTargetProperties(),
-                                            handle.GetMaxComputeUnits(),
-                                            kern.kernel_file,
-                                            comp_opts,
-                                            false);
+        }
+        return hsaco;
+    }
 
-            if(hsaco.empty())
+    // Hash, compress and encode a code object for the json output. With a
+    // blob store the compressed code object is written to the store and the
+    // json only refers to it.
+    static json PackageKernel(const miopen::solver::KernelInfo& kern,
+                              const std::string& hsaco,
+                              const BlobStore* store = nullptr)
+    {
+        json kernel;
+        auto md5_sum           = miopen::md5(hsaco);
+        auto size              = hsaco.size();
+        bool success           = false;
+        auto compressed_hsaco  = miopen::compress(hsaco, &success);
+        kernel["kernel_file"]  = kern.kernel_file;
+        kernel["comp_options"] = kern.comp_options;
+
+        if(success)
+        {
+            kernel["uncompressed_size"] = size;
+            kernel["md5_sum"]           = md5_sum;
+            if(store != nullptr)
+                kernel["blob_path"] = store->Put(md5_sum, compressed_hsaco);
+            else
+                kernel["blob"] = base64_encode(compressed_hsaco);
+        }
+        else
+        {
+            kernel["md5_sum"]           = "Failed to compress kernel";
+            kernel["uncompressed_size"] = 0;
+            kernel["blob"]              = "";
+        }
+        return kernel;
+    }
+
+    // "blob_store" in the job is a directory the compressed code objects are
+    // written to, instead of being embedded in the output
+    void InitBlobStore(const json& job)
+    {
+        blob_store.reset();
+        if(job.contains("blob_store"))
+            blob_store = std::make_unique<BlobStore>(job["blob_store"].get<std::string>());
+    }
+
+    // Device workspace shared by the solvers of all the jobs run by this
+    // thread. It is freed when a job thread exits, the main thread releases
+    // its own before returning from main.
+    static WorkspacePool& DeviceWorkspace()
+    {
+        static thread_local WorkspacePool pool{DeviceAllocator()};
+        return pool;
+    }
+
+    // The largest workspace of the solvers in a list of compile results
+    static size_t GetMaxWorkspace(const json& results)
+    {
+        size_t max_workspace = 0;
+        for(const auto& res_item : results)
+            if(res_item.contains("workspace") && res_item["workspace"].is_number())
+                max_workspace = std::max(max_workspace, res_item["workspace"].get<size_t>());
+        return max_workspace;
+    }
+
+    // Options of the job that apply to all its steps
+    void InitJobOptions(const json& job)
+    {
+        InitKernelDedup(job);
+        InitBlobStore(job);
+        // a fixed number of runs unless the job asks for something else
+        bench_config           = BenchmarkConfig{};
+        bench_config.min_iters = INVOKE_LIMIT;
+        bench_config.max_iters = INVOKE_LIMIT;
+        // a host device records no kernel times
+        if(DeviceAllocator()->IsHost())
+            bench_config.timer = "host";
+        if(job.contains("benchmark"))
+            bench_config = BenchmarkConfig::FromJson(job["benchmark"], bench_config);
+        kernel_refs_only = job.value("kernel_refs_only", false);
+    }
+
+    // Removes the blobs from the kernel objects of the step results in a job,
+    // along with its "kernel_blobs" table
+    static void StripKernelBlobs(json& job)
+    {
+        job.erase("kernel_blobs");
+        for(auto& item : job.items())
+        {
+            if(!item.value().is_array())
+                continue;
+            for(auto& res_item : item.value())
+                if(res_item.is_object() && res_item.contains("kernel_objects"))
+                    for(auto& kernel_obj : res_item["kernel_objects"])
+                        kernel_obj.erase("blob");
+        }
+    }
+
+    // Kernel objects for the kernels of a solution. With "kernel_refs_only"
+    // the kernels that were given in the input are not packaged again, they
+    // are only referenced by their md5.
+    json BuildJsonKernelRefs(const miopen::Handle& handle,
+                             const std::vector<miopen::solver::KernelInfo>& kernels,
+                             const json& input_kernels)
+    {
+        if(!kernel_refs_only)
+            return BuildJsonKernelList(handle, kernels);
+        std::unordered_map<std::string, const json*> known;
+        for(const auto& kernel_obj : input_kernels)
+            known.emplace(KernelKey(kernel_obj["kernel_file"], kernel_obj["comp_options"], ""),
+                          &kernel_obj);
+        json kernel_list = json::array();
+        for(const auto& kern : kernels)
+        {
+            const auto it = known.find(KernelKey(kern.kernel_file, kern.comp_options, ""));
+            if(it == known.end())
             {
-                auto p = handle.LoadProgram(kern.kernel_file, kern.comp_options, false, "");
-                hsaco  = p.IsCodeObjectInMemory()
-                             ? p.GetCodeObjectBlob()
-                             : miopen::LoadFile(p.GetCodeObjectPathname().string());
-                if(hsaco.empty())
-                {
-                    std::cerr << "Got empty code object" << std::endl;
-                    throw std::runtime_error("Got empty code object");
-                }
+                kernel_list.push_back(PackageKernelBinary(handle, kern));
+                continue;
             }
-            // Compress the blob
-            auto md5_sum             = miopen::md5(hsaco);
-            auto size                = hsaco.size();
-            bool success             = false;
-            auto compressed_hsaco    = miopen::compress(hsaco, &success);
-            const auto encoded_hsaco = base64_encode(compressed_hsaco);
-            kernel["kernel_file"]    = kern.kernel_file;
-            kernel["comp_options"]   = kern.comp_options;
-
-            if(success)
+            json kernel;
+            kernel["kernel_file"]       = kern.kernel_file;
+            kernel["comp_options"]      = kern.comp_options;
+            kernel["md5_sum"]           = (*it->second)["md5_sum"];
+            kernel["uncompressed_size"] = (*it->second)["uncompressed_size"];
+            kernel_list.push_back(kernel);
+        }
+        return kernel_list;
+    }
+
+    // "dedup_kernels" in the job packages every distinct kernel once, either
+    // for the "job" or for the whole "run". The blobs are then emitted once
+    // per job in "kernel_blobs" and the kernel objects refer to them by md5.
+    // The run cache is bounded, kernels dropped from it are packaged again.
+    void InitKernelDedup(const json& job)
+    {
+        kernel_dedup = nullptr;
+        job_dedup.reset();
+        job_blobs = json::object();
+        if(!job.contains("dedup_kernels"))
+            return;
+        const std::string scope = job["dedup_kernels"];
+        if(scope == "job")
+        {
+            job_dedup    = std::make_unique<KernelDedup>();
+            kernel_dedup = job_dedup.get();
+        }
+        else if(scope == "run")
+            kernel_dedup = &KernelDedup::RunCache();
+        else if(scope != "none")
+            throw std::runtime_error("Invalid dedup_kernels: " + scope);
+    }
+
+    bool IsKnownKernel(const miopen::Handle& handle, const miopen::solver::KernelInfo& kern) const
+    {
+        return kernel_dedup != nullptr &&
+               kernel_dedup->Contains(
+                   KernelKey(kern.kernel_file, kern.comp_options, handle.GetDeviceName()));
+    }
+
+    json PackageKernelBinary(const miopen::Handle& handle,
+                             const miopen::solver::KernelInfo& kern,
+                             std::mutex* mtx = nullptr)
+    {
+        const auto make = [&]() {
+            return PackageKernel(kern, LoadKernelBinary(handle, kern, mtx), blob_store.get());
+        };
+        if(kernel_dedup == nullptr)
+            return make();
+        auto kernel = kernel_dedup->Get(
+            KernelKey(kern.kernel_file, kern.comp_options, handle.GetDeviceName()), make);
+        // kernels that failed to compress keep their (empty) blob inline
+        if(!kernel.contains("blob") || kernel["blob"].get<std::string>().empty())
+            return kernel;
+        json blob;
+        blob["uncompressed_size"] = kernel["uncompressed_size"];
+        blob["blob"]              = std::move(kernel["blob"]);
+        kernel.erase("blob");
+        std::lock_guard<std::mutex> lock(blobs_mtx);
+        job_blobs.emplace(kernel["md5_sum"].get<std::string>(), std::move(blob));
+        return kernel;
+    }
+
+    // Add the blobs referenced by the result list to the "kernel_blobs" of
+    // the output, when kernels are deduplicated
+    void AddKernelBlobs(const json& results)
+    {
+        if(kernel_dedup == nullptr)
+            return;
+        if(!output.contains("kernel_blobs"))
+            output["kernel_blobs"] = json::object();
+        auto& table = output["kernel_blobs"];
+        for(const auto& res_item : results)
+        {
+            if(!res_item.contains("kernel_objects"))
+                continue;
+            for(const auto& kernel : res_item["kernel_objects"])
             {
-                kernel["uncompressed_size"] = size;
-                kernel["md5_sum"]           = md5_sum;
-                kernel["blob"]              = encoded_hsaco;
+                if(!kernel.contains("md5_sum"))
+                    continue;
+                const std::string md5_sum = kernel["md5_sum"];
+                auto it                   = job_blobs.find(md5_sum);
+                if(it != job_blobs.end() && !table.contains(md5_sum))
+                    table[md5_sum] = *it;
             }
-            else
+        }
+    }
+
+    json BuildJsonKernelList(const miopen::Handle& handle,
+                             const std::vector<miopen::solver::KernelInfo>& kernels,
+                             size_t num_threads = 1)
+    {
+        // Get the binary
+        json kernel_list = json::array();
+        if(num_threads <= 1 || kernels.size() <= 1)
+        {
+            for(const auto& kern : kernels)
+                kernel_list.push_back(PackageKernelBinary(handle, kern));
+            return kernel_list;
+        }
+
+        const auto package = [&](const miopen::solver::KernelInfo& kern) {
+            return PackageKernelBinary(handle, kern, &handle_mtx);
+        };
+        ThreadPool pool(std::min(num_threads, kernels.size()));
+        std::vector<std::future<json>> packaged;
+        for(const auto& kern : kernels)
+            packaged.push_back(pool.Submit([&package, kern]() { return package(kern); }));
+        for(auto& kernel : packaged)
+            kernel_list.push_back(kernel.get());
+        return kernel_list;
+    }
+
+    // Compile the kernels in batches and package the binaries of a batch on
+    // worker threads while the next batch is being compiled. The kernel list
+    // keeps the order of the input kernels.
+    json PrecompileJsonKernelList(const miopen::Handle& handle,
+                                  const std::vector<miopen::solver::KernelInfo>& kernels,
+                                  size_t num_threads)
+    {
+        // kernels already packaged for this job or run are not compiled again
+        const auto to_compile = [&](auto first, auto last) {
+            std::vector<miopen::solver::KernelInfo> batch;
+            std::copy_if(first, last, std::back_inserter(batch), [&](const auto& kern) {
+                return !IsKnownKernel(handle, kern);
+            });
+            return batch;
+        };
+        if(num_threads <= 1)
+        {
+            const auto batch = to_compile(kernels.begin(), kernels.end());
+            std::ignore      = miopen::solver::PrecompileKernels(handle, batch);
+            return BuildJsonKernelList(handle, kernels);
+        }
+
+        const auto package = [&](const miopen::solver::KernelInfo& kern) {
+            return PackageKernelBinary(handle, kern, &handle_mtx);
+        };
+        const size_t batch_size = std::max<size_t>(64, 4 * num_threads);
+        ThreadPool pool(num_threads);
+        std::vector<std::future<json>> packaged;
+        packaged.reserve(kernels.size());
+        for(size_t start = 0; start < kernels.size(); start += batch_size)
+        {
+            const auto end   = std::min(start + batch_size, kernels.size());
+            const auto first = kernels.begin() + start;
+            const auto last  = kernels.begin() + end;
             {
-                kernel["md5_sum"]           = "Failed to compress kernel";
-                kernel["uncompressed_size"] = 0;
-                kernel["blob"]              = "";
+                std::lock_guard<std::mutex> lock(handle_mtx);
+                std::ignore = miopen::solver::PrecompileKernels(handle, to_compile(first, last));
             }
-            kernel_list.push_back(kernel);
-            // std::cerr << "Successfully added new kernel to json output" << std::endl;
+            std::cerr << "Compiled kernels " << start << " to " << end << " of "
+                      << kernels.size() << std::endl;
+            for(auto kern = first; kern != last; ++kern)
+                packaged.push_back(pool.Submit([&package, kern]() { return package(*kern); }));
         }
+        json kernel_list = json::array();
+        for(auto& kernel : packaged)
+            kernel_list.push_back(kernel.get());
         return kernel_list;
     }
 
@@ -228,51 +605,55 @@ class BaseFin
         }
     }
 
-    float BenchmarkInvoker(const miopen::Invoker& invoker,
-                           const miopen::Handle& h,
-                           const miopen::conv::DataInvokeParams& invoke_ctx)
+    // The invoker a solution is timed with. Kernels can not run on a host
+    // device, there a stub invoker stands in for them, so that the eval steps
+    // can be timed end to end without a GPU.
+    miopen::Invoker PrepareTimedInvoker(miopen::Handle& handle,
+                                        const miopen::solver::ConvSolution& solution)
     {
-        float kernel_time;
-        std::vector<float> ktimes;
-        // warmup run
-        invoker(h, invoke_ctx);
-        for(auto idx = 0; idx < INVOKE_LIMIT; idx++)
-        {
-            invoker(h, invoke_ctx);
-            kernel_time = h.GetKernelTime();
-            ktimes.push_back(kernel_time);
-            std::cerr << "kernel_time : " << kernel_time << std::endl;
-        }
-        sort(ktimes.begin(), ktimes.end());
-        kernel_time = ktimes[(ktimes.size() - 1) / 2];
-        std::cerr << "kernel_time median : " << kernel_time << std::endl;
-        return kernel_time;
+        if(DeviceAllocator()->IsHost())
+            return [](const miopen::Handle&, const miopen::AnyInvokeParams&) {};
+        return handle.PrepareInvoker(*solution.invoker_factory, solution.construction_params);
     }
 
-    float BenchmarkInvoker(const miopen::Invoker& invoker,
-                           const miopen::Handle& h,
-                           const miopen::conv::WrWInvokeParams& invoke_ctx)
+    // Benchmarks an invoker with any of the invoke params types
+    template <typename Params>
+    BenchmarkStats BenchmarkInvoker(const miopen::Invoker& invoker,
+                                    const miopen::Handle& h,
+                                    const Params& invoke_ctx)
     {
-        float kernel_time;
-        std::vector<float> ktimes;
-        // warmup run
-        invoker(h, invoke_ctx);
-        for(auto idx = 0; idx < INVOKE_LIMIT; idx++)
+        const auto invoke = [&](const Params& params) { invoker(h, params); };
+#if FIN_BACKEND_HIP
+        if(bench_config.timer == "events")
+        {
+            HipEventTimer timer{h};
+            return BenchmarkInvocations(bench_config, invoke, invoke_ctx, timer);
+        }
+#endif
+        if(bench_config.timer == "host")
         {
-            invoker(h, invoke_ctx);
-            kernel_time = h.GetKernelTime();
-            ktimes.push_back(kernel_time);
-            std::cerr << "kernel_time : " << kernel_time << std::endl;
+            HostTimer timer;
+            return BenchmarkInvocations(bench_config, invoke, invoke_ctx, timer);
         }
-        sort(ktimes.begin(), ktimes.end());
-        kernel_time = ktimes[(ktimes.size() - 1) / 2];
-        std::cerr << "kernel_time median : " << kernel_time << std::endl;
-        return kernel_time;
+        HandleKernelTimer timer{h};
+        return BenchmarkInvocations(bench_config, invoke, invoke_ctx, timer);
     }
 
     protected:
     template <typename Tgpu>
     void InitDataType();
+    // guards compilation through a handle shared by worker threads
+    std::mutex handle_mtx;
+    // set by InitKernelDedup, null when kernels are not deduplicated
+    KernelDedup* kernel_dedup = nullptr;
+    std::unique_ptr<KernelDedup> job_dedup;
+    // blobs of the kernels packaged by this job, keyed by md5
+    json job_blobs = json::object();
+    std::mutex blobs_mtx;
+    // set by InitBlobStore, null when blobs are embedded in the output
+    std::unique_ptr<BlobStore> blob_store;
+    BenchmarkConfig bench_config;
+    bool kernel_refs_only = false;
     miopenDataType_t data_type = miopenFloat; // the datatype passed in through the command line
 
 #if FIN_BACKEND_OPENCL
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_FLOAT_CONVERT_HPP
+#define GUARD_FIN_FLOAT_CONVERT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FIN_HAS_X86_DISPATCH 1
+#else
+#define FIN_HAS_X86_DISPATCH 0
+#endif
+
+namespace fin {
+namespace detail {
+
+inline uint32_t FloatBits(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// IEEE binary16 with round to nearest even, same result as vcvtps2ph
+inline uint16_t FloatToHalfBits(float f)
+{
+    const uint32_t bits = FloatBits(f);
+    const auto sign     = static_cast<uint16_t>((bits >> 16) & 0x8000U);
+    const uint32_t abs  = bits & 0x7fffffffU;
+
+    if(abs >= 0x7f800000U) // inf or nan, keep nan quiet
+        return sign | 0x7c00U | (abs > 0x7f800000U ? 0x0200U | ((abs >> 13) & 0x3ffU) : 0U);
+    if(abs >= 0x477ff000U) // rounds to a value above the half range
+        return sign | 0x7c00U;
+    if(abs < 0x38800000U) // result is a half denormal or zero
+    {
+        if(abs < 0x33000000U)
+            return sign;
+        const uint32_t exp      = abs >> 23;
+        const uint32_t mant     = (abs & 0x7fffffU) | 0x800000U;
+        const uint32_t shift    = 126 - exp;
+        const uint32_t half     = mant >> shift;
+        const uint32_t rest     = mant & ((1U << shift) - 1);
+        const uint32_t halfway  = 1U << (shift - 1);
+        const uint32_t round_up = rest > halfway || (rest == halfway && (half & 1U));
+        return sign | static_cast<uint16_t>(half + round_up);
+    }
+    const uint32_t rounded = abs + 0xfffU + ((abs >> 13) & 1U) - 0x38000000U;
+    return sign | static_cast<uint16_t>(rounded >> 13);
+}
+
+// bfloat16 with round to nearest even, nan stays nan
+inline uint16_t FloatToBFloat16Bits(float f)
+{
+    const uint32_t bits = FloatBits(f);
+    if((bits & 0x7fffffffU) > 0x7f800000U)
+        return static_cast<uint16_t>((bits >> 16) | 0x40U);
+    return static_cast<uint16_t>((bits + 0x7fffU + ((bits >> 16) & 1U)) >> 16);
+}
+
+#if FIN_HAS_X86_DISPATCH
+__attribute__((target("avx,f16c"))) inline size_t
+ConvertFloatsToHalfBitsF16C(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    return i;
+}
+
+inline bool HasF16C()
+{
+    static const bool has_f16c = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+    return has_f16c;
+}
+#endif
+
+} // namespace detail
+
+// Bulk float to binary16 conversion. Uses F16C when the CPU has it, the
+// scalar fallback produces the same bits.
+inline void ConvertFloatsToHalfBits(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+#if FIN_HAS_X86_DISPATCH
+    if(detail::HasF16C())
+        i = detail::ConvertFloatsToHalfBitsF16C(src, dst, n);
+#endif
+    for(; i < n; i++)
+        dst[i] = detail::FloatToHalfBits(src[i]);
+}
+
+// Bulk float to bfloat16 conversion. The native instruction is used when
+// the build targets AVX-512 BF16, it treats denormal inputs as zero.
+// Otherwise the branch free scalar loop is left to the auto vectorizer.
+inline void ConvertFloatsToBFloat16Bits(const float* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX512BF16__) && defined(__AVX512F__)
+    for(; i + 16 <= n; i += 16)
+    {
+        const __m256bh b = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+        std::memcpy(dst + i, &b, sizeof(b));
+    }
+#endif
+    for(; i < n; i++)
+        dst[i] = detail::FloatToBFloat16Bits(src[i]);
+}
+
+} // namespace fin
+#endif // GUARD_FIN_FLOAT_CONVERT_HPP
@@ -44,6 +44,8 @@
 
 #include <hip/hip_runtime_api.h>
 
+#include "allocator.hpp"
+
 namespace fin {
 
 struct relMem
@@ -51,7 +53,10 @@ struct relMem
 #if FIN_BACKEND_OPENCL
     void operator()(cl_mem ptr) { clReleaseMemObject(ptr); }
 #elif FIN_BACKEND_HIP
-    void operator()(void* ptr) { std::ignore = hipFree(ptr); }
+    // the buffer goes back to the arena it came from
+    std::shared_ptr<BufferArena> arena;
+    size_t bytes;
+    void operator()(void* ptr) { arena->Release(ptr, bytes); }
 #endif
 };
 #if FIN_BACKEND_OPENCL
@@ -78,6 +83,12 @@ struct GPUMem
     {
         return clEnqueueReadBuffer(q, buf.get(), CL_TRUE, 0, data_sz * sz, p, 0, nullptr, nullptr);
     }
+    int Zero(cl_command_queue& q)
+    {
+        const cl_uchar zero = 0;
+        return clEnqueueFillBuffer(
+            q, buf.get(), &zero, sizeof(zero), 0, data_sz * sz, 0, nullptr, nullptr);
+    }
 
     cl_mem GetMem() { return buf.get(); }
     size_t GetSize() { return sz * data_sz; }
@@ -88,31 +99,35 @@ struct GPUMem
 #elif FIN_BACKEND_HIP
 
     GPUMem(){};
+    // The memory comes from the process wide device arena, buffers of
+    // earlier jobs with the same size are reused
     GPUMem(uint32_t ctx, size_t psz, size_t pdata_sz) : _ctx(ctx), sz(psz), data_sz(pdata_sz)
     {
-        void* tmp = nullptr;
-        const auto status = hipMalloc(static_cast<void**>(&(tmp)), data_sz * sz);
-        if(status != hipSuccess || (tmp == nullptr && sz > 0))
-            throw std::runtime_error("Unable to allocate GPU memory");
-        buf = gpu_mem_ptr{tmp};
+        auto arena = DeviceArena();
+        void* ptr  = arena->Acquire(data_sz * sz);
+        buf        = gpu_mem_ptr{ptr, relMem{std::move(arena), data_sz * sz}};
     }
 
     int ToGPU(hipStream_t q, void* p)
     {
         _q = q;
-        return static_cast<int>(hipMemcpy(buf.get(), p, data_sz * sz, hipMemcpyHostToDevice));
+        return GetAllocator().CopyToDevice(buf.get(), p, data_sz * sz);
     }
     int FromGPU(hipStream_t q, void* p)
     {
-        const auto status = hipDeviceSynchronize();
-        if(status != hipSuccess)
-            throw std::runtime_error("Error while calling hipDeviceSynchronize()");
         _q = q;
-        return static_cast<int>(hipMemcpy(p, buf.get(), data_sz * sz, hipMemcpyDeviceToHost));
+        return GetAllocator().CopyFromDevice(p, buf.get(), data_sz * sz);
+    }
+    // Clears the buffer without staging zeros on the host
+    int Zero(hipStream_t q)
+    {
+        _q = q;
+        return GetAllocator().Memset(buf.get(), 0, data_sz * sz);
     }
 
     void* GetMem() { return buf.get(); }
     size_t GetSize() { return sz * data_sz; }
+    Allocator& GetAllocator() { return *buf.get_deleter().arena->GetAllocator(); }
 
     // ~GPUMem() { hipFree(buf); }
     hipStream_t _q; // Place holder for opencl context
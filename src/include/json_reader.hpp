@@ -0,0 +1,70 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_JSON_READER_HPP
+#define GUARD_FIN_JSON_READER_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <functional>
+#include <istream>
+#include <stdexcept>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+// Reads the top level array of jobs one element at a time and hands every
+// job to the callback as soon as it has been parsed. The job is dropped from
+// the parser state afterwards, so only the job currently being processed is
+// kept in memory instead of the whole input document.
+// Returns the number of jobs read.
+inline size_t ForEachJob(std::istream& is, const std::function<void(json&)>& handler)
+{
+    bool is_array = false;
+    size_t count  = 0;
+    json::parser_callback_t cb = [&](int depth, json::parse_event_t event, json& parsed) {
+        if(depth == 0 && event == json::parse_event_t::array_start)
+            is_array = true;
+        if(is_array && depth == 1 && event == json::parse_event_t::object_end)
+        {
+            ++count;
+            handler(parsed);
+            // discard the job, it has already been processed
+            return false;
+        }
+        return true;
+    };
+    const auto top = json::parse(is, cb);
+    if(!is_array)
+        throw std::runtime_error("Input json must be a list of jobs");
+    if(!top.empty())
+        throw std::runtime_error("Input json must only contain job objects");
+    return count;
+}
+
+} // namespace fin
+#endif // GUARD_FIN_JSON_READER_HPP
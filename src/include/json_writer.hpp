@@ -0,0 +1,107 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_JSON_WRITER_HPP
+#define GUARD_FIN_JSON_WRITER_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+// Writes job results to the output stream one at a time, so that a result
+// can be released as soon as it is written and the output of a crashed run
+// still holds every job that finished before the crash.
+// In the default mode the output is a JSON array (the same document the
+// tools downstream already parse), in NDJSON mode every result is written
+// on a line of its own.
+class JsonStreamWriter
+{
+    public:
+    JsonStreamWriter(std::ostream& _os, bool _ndjson = false) : os(_os), ndjson(_ndjson)
+    {
+        if(!ndjson)
+            os << "[" << std::flush;
+    }
+    JsonStreamWriter(const JsonStreamWriter&) = delete;
+    JsonStreamWriter& operator=(const JsonStreamWriter&) = delete;
+    ~JsonStreamWriter()
+    {
+        try
+        {
+            Close();
+        }
+        catch(...)
+        {
+        }
+    }
+
+    void Write(const json& item)
+    {
+        if(closed)
+            throw std::runtime_error("Unable to write to a closed json stream");
+        if(ndjson)
+        {
+            os << item.dump() << "\n";
+        }
+        else
+        {
+            if(count != 0)
+                os << ",";
+            os << "\n" << std::setw(4) << item;
+        }
+        ++count;
+        os.flush();
+        if(!os)
+            throw std::runtime_error("Error writing to the json output stream");
+    }
+
+    void Close()
+    {
+        if(closed)
+            return;
+        closed = true;
+        if(!ndjson)
+            os << "\n]" << std::endl;
+        os.flush();
+    }
+
+    size_t Count() const { return count; }
+
+    private:
+    std::ostream& os;
+    bool ndjson  = false;
+    bool closed  = false;
+    size_t count = 0;
+};
+
+} // namespace fin
+#endif // GUARD_FIN_JSON_WRITER_HPP
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_KERNEL_DEDUP_HPP
+#define GUARD_FIN_KERNEL_DEDUP_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <future>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+// Identity of a kernel binary. Runs of whitespace in the compile options do
+// not change the binary, they are collapsed so that such kernels share a key.
+inline std::string
+KernelKey(const std::string& kernel_file, const std::string& comp_options, const std::string& arch)
+{
+    std::istringstream iss(comp_options);
+    std::string opts;
+    std::string opt;
+    while(iss >> opt)
+    {
+        if(!opts.empty())
+            opts += ' ';
+        opts += opt;
+    }
+    return arch + '|' + kernel_file + '|' + opts;
+}
+
+// Packages every distinct kernel once. The first caller for a key builds the
+// entry, concurrent callers with the same key wait for it. Entries hold the
+// blob of the kernel, the least recently used ones are dropped once the
+// blobs take more than max_bytes and are packaged again when asked for.
+class KernelDedup
+{
+    public:
+    explicit KernelDedup(size_t _max_bytes = std::numeric_limits<size_t>::max())
+        : max_bytes(_max_bytes)
+    {
+    }
+    KernelDedup(const KernelDedup&) = delete;
+    KernelDedup& operator=(const KernelDedup&) = delete;
+
+    // Cache shared by all the jobs of a run
+    static KernelDedup& RunCache()
+    {
+        static KernelDedup cache{size_t{256} << 20};
+        return cache;
+    }
+
+    // make() returns a packaged kernel, including its blob
+    template <typename F>
+    json Get(const std::string& key, F make)
+    {
+        std::promise<json> promise;
+        std::shared_future<json> kernel;
+        bool owner = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = entries.find(key);
+            if(it == entries.end())
+            {
+                kernel = promise.get_future().share();
+                entries.emplace(key, Entry{kernel, 0, lru.end()});
+                owner = true;
+            }
+            else
+            {
+                kernel = it->second.kernel;
+                if(it->second.lru_pos != lru.end())
+                    lru.splice(lru.end(), lru, it->second.lru_pos);
+            }
+        }
+        if(!owner)
+            return kernel.get();
+        try
+        {
+            promise.set_value(make());
+        }
+        catch(...)
+        {
+            // let the next caller retry instead of failing on a stale error
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                entries.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        Track(key, BlobBytes(kernel.get()));
+        return kernel.get();
+    }
+
+    bool Contains(const std::string& key) const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return entries.count(key) > 0;
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return entries.size();
+    }
+
+    size_t Bytes() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return bytes;
+    }
+
+    private:
+    struct Entry
+    {
+        std::shared_future<json> kernel;
+        size_t bytes;
+        // end() while the kernel is being packaged
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    static size_t BlobBytes(const json& kernel)
+    {
+        return kernel.contains("blob") ? kernel["blob"].get_ref<const std::string&>().size() : 0;
+    }
+
+    void Track(const std::string& key, size_t entry_bytes)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(key);
+        if(it == entries.end())
+            return;
+        it->second.bytes   = entry_bytes;
+        it->second.lru_pos = lru.insert(lru.end(), key);
+        bytes += entry_bytes;
+        // the entry just added is kept even if it is over the limit on its own
+        while(bytes > max_bytes && lru.size() > 1)
+        {
+            auto oldest = entries.find(lru.front());
+            bytes -= oldest->second.bytes;
+            entries.erase(oldest);
+            lru.pop_front();
+        }
+    }
+
+    mutable std::mutex mtx;
+    std::unordered_map<std::string, Entry> entries;
+    // keys of the packaged entries, least recently used first
+    std::list<std::string> lru;
+    size_t bytes = 0;
+    size_t max_bytes;
+};
+
+} // namespace fin
+
+#endif // GUARD_FIN_KERNEL_DEDUP_HPP
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_KERNEL_LOADER_HPP
+#define GUARD_FIN_KERNEL_LOADER_HPP
+
+#include "blob_store.hpp"
+#include "thread_pool.hpp"
+
+#include <nlohmann/json.hpp>
+#include <miopen/bz2.hpp>
+#include <miopen/md5.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace fin {
+
+using json = nlohmann::json;
+
+// A code object from the kernel objects of a compile result, ready to be
+// added to a handle
+struct DecodedKernel
+{
+    std::string kernel_file;
+    std::string comp_options;
+    std::string hsaco;
+    // the md5 of the code object matches the one recorded at compile time
+    bool valid = false;
+};
+
+inline DecodedKernel DecodeKernelObject(const json& kernel_obj, const json& job)
+{
+    DecodedKernel kernel;
+    kernel.kernel_file        = kernel_obj["kernel_file"];
+    kernel.comp_options       = kernel_obj["comp_options"];
+    const size_t size         = kernel_obj["uncompressed_size"];
+    const std::string md5_sum = kernel_obj["md5_sum"];
+    kernel.hsaco              = miopen::decompress(LoadCompressedKernel(kernel_obj, job), size);
+    kernel.valid              = miopen::md5(kernel.hsaco) == md5_sum;
+    return kernel;
+}
+
+// The perf configs a compile result lists in "params", either a single
+// config or a list of them, so that the eval times exactly those
+inline std::vector<std::string> GetCompiledPerfCfgs(const json& result)
+{
+    if(!result.contains("params"))
+        return {};
+    if(result["params"].is_array())
+        return result["params"].get<std::vector<std::string>>();
+    return {result["params"].get<std::string>()};
+}
+
+// Decodes the kernel objects of the compile results ahead of the solver that
+// is being evaluated. Requesting the kernels of a result queues the decoding
+// of the next results, up to the lookahead, so that it overlaps with the
+// setup and benchmarking of the current solver. Results the consumer moved
+// past are dropped, and results the filter rejects are never decoded.
+class KernelPrefetcher
+{
+    public:
+    using Filter = std::function<bool(const json&)>;
+
+    KernelPrefetcher(const json& _results,
+                     const json& _job,
+                     size_t num_threads,
+                     size_t _lookahead = 0,
+                     Filter _filter    = nullptr)
+        : results(_results),
+          job(_job),
+          lookahead(_lookahead == 0 ? std::max<size_t>(num_threads, 1) : _lookahead),
+          filter(std::move(_filter)),
+          pending(_results.size()),
+          pool(std::max<size_t>(num_threads, 1))
+    {
+    }
+
+    // Blocks until the kernels of the result at idx are decoded, errors while
+    // decoding are rethrown here. The results before idx are not asked for
+    // anymore.
+    std::vector<DecodedKernel> Get(size_t idx)
+    {
+        for(size_t skipped = cursor; skipped < std::min(idx, queued); skipped++)
+            pending[skipped].clear();
+        cursor = std::max<size_t>(cursor, idx);
+        for(; queued < std::min(idx + 1 + lookahead, results.size()); queued++)
+            Queue(queued);
+        // the filter does not have the final say on a result that is asked for
+        if(pending[idx].empty())
+            Queue(idx, true);
+        std::vector<DecodedKernel> kernels;
+        kernels.reserve(pending[idx].size());
+        for(auto& kernel : pending[idx])
+            kernels.push_back(kernel.get());
+        pending[idx].clear();
+        return kernels;
+    }
+
+    private:
+    void Queue(size_t idx, bool force = false)
+    {
+        if(!results[idx].contains("kernel_objects"))
+            return;
+        // solvers that are going to be skipped do not need their kernels
+        if(!force && idx != cursor && filter && !filter(results[idx]))
+            return;
+        for(const auto& kernel_obj : results[idx]["kernel_objects"])
+        {
+            pending[idx].push_back(pool.Submit([this, idx, &kernel_obj]() {
+                // the consumer may have moved past the result in the meantime
+                if(idx < cursor)
+                    return DecodedKernel{};
+                return DecodeKernelObject(kernel_obj, job);
+            }));
+        }
+    }
+
+    const json& results;
+    const json& job;
+    const size_t lookahead;
+    const Filter filter;
+    size_t queued = 0;
+    // index of the result the consumer asked for last
+    std::atomic<size_t> cursor{0};
+    std::vector<std::vector<std::future<DecodedKernel>>> pending;
+    // declared last, so that the workers are joined before the members they
+    // use are destroyed
+    ThreadPool pool;
+};
+
+} // namespace fin
+
+#endif // GUARD_FIN_KERNEL_LOADER_HPP
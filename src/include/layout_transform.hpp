@@ -0,0 +1,188 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_LAYOUT_TRANSFORM_HPP
+#define GUARD_FIN_LAYOUT_TRANSFORM_HPP
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace fin {
+
+// Host side conversions between packed tensor layouts. Spatial dims are
+// flattened into S = D * H * W, so every transform covers 2D and 3D
+// tensors. Vectorized layouts pad the channels up to a multiple of the
+// vector length with zeros. All work is split over num_threads threads.
+
+// dst[j * dst_ld + i] = src[i * src_ld + j] for i < rows and j < cols. The
+// matrix is walked in square tiles, so both the rows read and the rows
+// written stay in L1 while a tile is copied.
+template <typename T>
+void TransposeBlocked(
+    const T* src, size_t src_ld, T* dst, size_t dst_ld, size_t rows, size_t cols)
+{
+    constexpr size_t tile = 64 / sizeof(T) < 8 ? 8 : 64 / sizeof(T);
+    for(size_t i0 = 0; i0 < rows; i0 += tile)
+    {
+        const size_t i1 = std::min(i0 + tile, rows);
+        for(size_t j0 = 0; j0 < cols; j0 += tile)
+        {
+            const size_t j1 = std::min(j0 + tile, cols);
+            for(size_t j = j0; j < j1; j++)
+                for(size_t i = i0; i < i1; i++)
+                    dst[j * dst_ld + i] = src[i * src_ld + j];
+        }
+    }
+}
+
+// N x C x S -> N x S x C
+template <typename T>
+void NchwToNhwc(const T* src, T* dst, size_t n, size_t c, size_t s, size_t num_threads = 1)
+{
+    ParallelFor(n, num_threads, [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; b++)
+            TransposeBlocked(src + b * c * s, s, dst + b * c * s, c, c, s);
+    });
+}
+
+// N x S x C -> N x C x S
+template <typename T>
+void NhwcToNchw(const T* src, T* dst, size_t n, size_t c, size_t s, size_t num_threads = 1)
+{
+    ParallelFor(n, num_threads, [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; b++)
+            TransposeBlocked(src + b * c * s, c, dst + b * c * s, s, s, c);
+    });
+}
+
+// N x C x S -> C x S x N
+template <typename T>
+void NchwToChwn(const T* src, T* dst, size_t n, size_t c, size_t s, size_t num_threads = 1)
+{
+    const size_t cs = c * s;
+    ParallelFor(cs, num_threads, [&](size_t begin, size_t end) {
+        TransposeBlocked(src + begin, cs, dst + begin * n, n, n, end - begin);
+    });
+}
+
+// Number of channels after padding to a multiple of the vector length
+inline size_t PaddedChannels(size_t c, size_t vec) { return (c + vec - 1) / vec * vec; }
+
+// N x C x S -> N x ceil(C / vec) x S x vec
+template <typename T>
+void NchwToNchwVect(
+    const T* src, T* dst, size_t n, size_t c, size_t s, size_t vec, size_t num_threads = 1)
+{
+    const size_t blocks = PaddedChannels(c, vec) / vec;
+    ParallelFor(n * blocks, num_threads, [&](size_t begin, size_t end) {
+        for(size_t task = begin; task < end; task++)
+        {
+            const size_t b     = task / blocks;
+            const size_t c0    = (task % blocks) * vec;
+            const size_t lanes = std::min(vec, c - c0);
+            T* out             = dst + task * s * vec;
+            if(lanes < vec)
+                std::fill(out, out + s * vec, T(0));
+            TransposeBlocked(src + (b * c + c0) * s, s, out, vec, lanes, s);
+        }
+    });
+}
+
+// N x ceil(C / vec) x S x vec -> N x C x S, the padding lanes are dropped
+template <typename T>
+void NchwVectToNchw(
+    const T* src, T* dst, size_t n, size_t c, size_t s, size_t vec, size_t num_threads = 1)
+{
+    const size_t blocks = PaddedChannels(c, vec) / vec;
+    ParallelFor(n * blocks, num_threads, [&](size_t begin, size_t end) {
+        for(size_t task = begin; task < end; task++)
+        {
+            const size_t b     = task / blocks;
+            const size_t c0    = (task % blocks) * vec;
+            const size_t lanes = std::min(vec, c - c0);
+            TransposeBlocked(src + task * s * vec, vec, dst + (b * c + c0) * s, s, s, lanes);
+        }
+    });
+}
+
+// N x C x S -> ceil(C / vec) x S x N x vec
+template <typename T>
+void NchwToChwnVect(
+    const T* src, T* dst, size_t n, size_t c, size_t s, size_t vec, size_t num_threads = 1)
+{
+    const size_t blocks = PaddedChannels(c, vec) / vec;
+    ParallelFor(blocks, num_threads, [&](size_t begin, size_t end) {
+        for(size_t block = begin; block < end; block++)
+        {
+            const size_t c0    = block * vec;
+            const size_t lanes = std::min(vec, c - c0);
+            T* out             = dst + block * s * n * vec;
+            if(lanes < vec)
+                std::fill(out, out + s * n * vec, T(0));
+            // lane l of sample b lands at out[(si * n + b) * vec + l]
+            for(size_t b = 0; b < n; b++)
+                TransposeBlocked(src + (b * c + c0) * s, s, out + b * vec, n * vec, lanes, s);
+        }
+    });
+}
+
+// ceil(C / vec) x S x N x vec -> N x C x S
+template <typename T>
+void ChwnVectToNchw(
+    const T* src, T* dst, size_t n, size_t c, size_t s, size_t vec, size_t num_threads = 1)
+{
+    const size_t blocks = PaddedChannels(c, vec) / vec;
+    ParallelFor(blocks, num_threads, [&](size_t begin, size_t end) {
+        for(size_t block = begin; block < end; block++)
+        {
+            const size_t c0    = block * vec;
+            const size_t lanes = std::min(vec, c - c0);
+            const T* in        = src + block * s * n * vec;
+            for(size_t b = 0; b < n; b++)
+                TransposeBlocked(in + b * vec, n * vec, dst + (b * c + c0) * s, s, s, lanes);
+        }
+    });
+}
+
+// N x C x S -> N x C_pad x S with the extra channels zeroed, as used for
+// int8 convolutions whose channel count is not a multiple of four
+template <typename T>
+void PadChannels(
+    const T* src, T* dst, size_t n, size_t c, size_t c_pad, size_t s, size_t num_threads = 1)
+{
+    ParallelFor(n, num_threads, [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; b++)
+        {
+            std::copy(src + b * c * s, src + (b + 1) * c * s, dst + b * c_pad * s);
+            std::fill(dst + (b * c_pad + c) * s, dst + (b + 1) * c_pad * s, T(0));
+        }
+    });
+}
+
+} // namespace fin
+#endif // GUARD_FIN_LAYOUT_TRANSFORM_HPP
@@ -27,18 +27,93 @@
 #ifndef GUARD_FIN_RANDOM_GEN_
 #define GUARD_FIN_RANDOM_GEN_
 
-template <typename T>
-static T FRAND(void)
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace fin {
+
+// Philox4x32-10 counter based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"). The output is a pure function of the
+// counter and the key, so any element can be generated independently of
+// the others and in any order.
+struct Philox4x32
 {
-    double d = static_cast<double>(rand() / (static_cast<double>(RAND_MAX)));
-    return static_cast<T>(d);
-}
+    using counter_type = std::array<uint32_t, 4>;
+    using key_type     = std::array<uint32_t, 2>;
+
+    static counter_type Generate(counter_type ctr, key_type key)
+    {
+        for(int round = 0; round < 10; round++)
+        {
+            if(round != 0)
+            {
+                key[0] += 0x9E3779B9U;
+                key[1] += 0xBB67AE85U;
+            }
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53U) * ctr[0];
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57U) * ctr[2];
+            const uint32_t c1 = ctr[1];
+            const uint32_t c3 = ctr[3];
+            ctr[0]            = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ key[0];
+            ctr[1]            = static_cast<uint32_t>(p1);
+            ctr[2]            = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ key[1];
+            ctr[3]            = static_cast<uint32_t>(p0);
+        }
+        return ctr;
+    }
+};
 
-template <typename T>
-static T RAN_GEN(T A, T B)
+// Random stream identified by (seed, stream). Element idx of the stream is
+// taken from word idx % 4 of Philox block idx / 4, which makes the data
+// independent of how the index range is split between threads.
+class CounterRng
 {
-    T r = (FRAND<T>() * (B - A)) + A;
-    return r;
-}
+    public:
+    CounterRng(uint64_t seed, uint32_t stream_id)
+        : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, stream(stream_id)
+    {
+    }
+
+    Philox4x32::counter_type Block(uint64_t block) const
+    {
+        return Philox4x32::Generate(
+            {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), stream, 0}, key);
+    }
+
+    uint32_t Bits(uint64_t idx) const { return Block(idx / 4)[idx % 4]; }
+
+    // Uniform float in [0, 1) with 24 bits of randomness
+    static float ToUniform(uint32_t bits)
+    {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float Uniform(uint64_t idx) const { return ToUniform(Bits(idx)); }
+
+    // Same values as Uniform(first) ... Uniform(first + count - 1), computing
+    // each Philox block only once
+    void FillUniform(uint64_t first, size_t count, float* out) const
+    {
+        const uint64_t last = first + count;
+        for(uint64_t idx = first; idx < last;)
+        {
+            const auto block = Block(idx / 4);
+            for(auto word = idx % 4; word < 4 && idx < last; word++, idx++)
+                *out++ = ToUniform(block[word]);
+        }
+    }
+
+    template <typename T>
+    T Range(uint64_t idx, T A, T B) const
+    {
+        return (static_cast<T>(Uniform(idx)) * (B - A)) + A;
+    }
+
+    private:
+    Philox4x32::key_type key;
+    uint32_t stream;
+};
 
+} // namespace fin
 #endif // GUARD_FIN_RANDOM_GEN_
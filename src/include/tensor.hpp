@@ -35,7 +35,24 @@
 #endif
 #include <miopen/bfloat16.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <cpu_tensor.hpp>
+#include <float_convert.hpp>
 #include <gpu_mem.hpp>
+#include <layout_transform.hpp>
+#include <random.hpp>
+#include <thread_pool.hpp>
 #include <miopen/tensor.hpp>
 #include <miopen/tensor_layout.hpp>
 
@@ -169,6 +186,89 @@ inline int SetTensorNd(miopenTensorDescriptor_t t,
     return SetTensorNd(t, len, strides, data_type);
 }
 
+// Host copy of a tensor, the memory comes from the process wide host arena
+template <typename T>
+using HostBuffer = std::vector<T, HostArenaAllocator<T>>;
+
+// Bytes the FilledDataCache of each data type may keep, zero unless the run
+// opts in
+inline std::atomic<size_t>& FilledDataMaxBytes()
+{
+    static std::atomic<size_t> max_bytes{0};
+    return max_bytes;
+}
+
+// Input data of finished jobs, keyed by what determines the data (see
+// GetFillKey). A later job with the same key takes the buffer over instead
+// of allocating and filling it again. At most FilledDataMaxBytes() are kept,
+// the least recently added buffers are dropped first.
+template <typename T>
+class FilledDataCache
+{
+    public:
+    static FilledDataCache& Instance()
+    {
+        static FilledDataCache cache;
+        return cache;
+    }
+
+    bool Take(const std::string& key, HostBuffer<T>& buffer)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        const auto it = std::find_if(
+            entries.begin(), entries.end(), [&](const auto& entry) { return entry.first == key; });
+        if(it == entries.end())
+            return false;
+        bytes -= it->second.size() * sizeof(T);
+        buffer = std::move(it->second);
+        entries.erase(it);
+        return true;
+    }
+
+    void Put(const std::string& key, HostBuffer<T>&& buffer)
+    {
+        if(buffer.size() * sizeof(T) > FilledDataMaxBytes())
+            return;
+        std::lock_guard<std::mutex> lock(mtx);
+        bytes += buffer.size() * sizeof(T);
+        entries.emplace_back(key, std::move(buffer));
+        while(bytes > FilledDataMaxBytes() && !entries.empty())
+        {
+            bytes -= entries.front().second.size() * sizeof(T);
+            entries.pop_front();
+        }
+    }
+
+    private:
+    std::mutex mtx;
+    std::list<std::pair<std::string, HostBuffer<T>>> entries;
+    size_t bytes = 0;
+};
+
+template <typename T>
+void ConvertFromFloat(const float* src, T* dst, size_t n)
+{
+    if constexpr(std::is_same<T, float16>{} || std::is_same<T, bfloat16>{})
+    {
+        static_assert(sizeof(T) == sizeof(uint16_t), "unexpected 16 bit float size");
+        std::array<uint16_t, 1024> bits;
+        for(size_t first = 0; first < n; first += bits.size())
+        {
+            const auto count = std::min(bits.size(), n - first);
+            if constexpr(std::is_same<T, float16>{})
+                ConvertFloatsToHalfBits(src + first, bits.data(), count);
+            else
+                ConvertFloatsToBFloat16Bits(src + first, bits.data(), count);
+            std::memcpy(dst + first, bits.data(), count * sizeof(uint16_t));
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < n; i++)
+            dst[i] = static_cast<T>(src[i]);
+    }
+}
+
 template <typename Tgpu, typename Tcpu>
 struct tensor
 {
@@ -182,12 +282,13 @@ struct tensor
     context_type ctx         = 0;
 #endif
     miopen::TensorDescriptor desc;
-    std::vector<Tgpu> cpuData;    // version of the data for the CPU compute
-    std::vector<Tgpu> deviceData; // home for the GPU data on the CPU side
+    HostBuffer<Tgpu> cpuData;    // host copy of an input, uploaded to the GPU
+    HostBuffer<Tgpu> deviceData; // readback of an output, filled by FromDevice
+    std::string fill_key;        // set when cpuData may go to the FilledDataCache
     GPUMem gpuData;               // object representing the GPU data ON the GPU
     accelerator_stream q;
-    bool is_input;
-    bool is_output;
+    bool is_input  = false;
+    bool is_output = false;
 
     tensor() {}
     // cppcheck-suppress uninitMemberVar
@@ -220,11 +321,17 @@ struct tensor
 #endif
     }
 
+    // The device result is read back into deviceData, which is only
+    // allocated when a readback is requested. It is zeroed, so that a failed
+    // readback does not leave the data of an earlier job behind.
     status_t FromDevice()
     {
         status_t status = 0;
         if(is_output)
+        {
+            deviceData.assign(desc.GetElementSpace(), static_cast<Tgpu>(0));
             status = gpuData.FromGPU(q, deviceData.data());
+        }
         return status;
     }
 
@@ -234,36 +341,124 @@ struct tensor
         if(is_input)
             status = gpuData.ToGPU(q, cpuData.data());
         else if(is_output)
-            status = gpuData.ToGPU(q, deviceData.data()); // to set the data to zero on the GPU
+            status = gpuData.Zero(q);
         return status;
     }
 
+    // Host memory is sized in elements, only input tensors keep a host copy
     void AllocateBuffers()
     {
+        cpuData.clear();
+        deviceData.clear();
+        fill_key.clear();
         if(is_input)
-            // TODO: check if the datatype is correct;
-            cpuData = std::vector<Tgpu>(desc.GetNumBytes(), static_cast<Tgpu>(0));
-
-        if(is_output)
-            deviceData = std::vector<Tgpu>(desc.GetNumBytes(), static_cast<Tgpu>(0));
+            cpuData.resize(desc.GetElementSpace(), static_cast<Tgpu>(0));
 
-        gpuData = GPUMem{ctx, desc.GetNumBytes() / sizeof(Tgpu), sizeof(Tgpu)};
+        gpuData = GPUMem{ctx, desc.GetElementSpace(), sizeof(Tgpu)};
     }
+    // Fill the input buffer with f(u, i), where u is element i of the rng
+    // stream and i the index of the element in N, C, (D,) H, W order, so the
+    // values do not depend on the memory layout. Values are computed as float
+    // in blocks and converted to Tgpu in bulk. The buffer is split between
+    // num_threads threads and the result does not depend on their number.
     template <typename F>
-    void FillBuffer(F f)
+    void FillBuffer(const CounterRng& rng, F f, size_t num_threads = 1)
     {
-        for(int i = 0; i < GetTensorSize(); i++)
+        if(!is_input)
+            return;
+        const auto layout = desc.GetLayout_t();
+        if(layout != miopenTensorNHWC && layout != miopenTensorNDHWC &&
+           layout != miopenTensorCHWN)
         {
-            if(is_input) // is input
-                cpuData[i] = f(i);
-            // Data_scale * RAN_GEN<Tgpu>(static_cast<Tgpu>(0.0),
-            // static_cast<Tgpu>(1.0));
-            else /// \ref move_rand
-                std::ignore = rand();
+            FillLogical(rng, f, cpuData.data(), num_threads);
+            return;
         }
+
+        // channels last layouts are filled in N, C, (D,) H, W order first
+        HostBuffer<Tgpu> logical(GetTensorSize());
+        FillLogical(rng, f, logical.data(), num_threads);
+        const auto& lens = desc.GetLengths();
+        const size_t s   = std::accumulate(
+            lens.begin() + 2, lens.end(), size_t{1}, std::multiplies<size_t>{});
+        if(layout == miopenTensorCHWN)
+            NchwToChwn(logical.data(), cpuData.data(), lens[0], lens[1], s, num_threads);
+        else
+            NchwToNhwc(logical.data(), cpuData.data(), lens[0], lens[1], s, num_threads);
     }
 
     size_t GetTensorSize() { return desc.GetElementSize(); }
+
+    // Everything the data of FillBuffer(CounterRng{seed, stream}, f) depends
+    // on, given that f is fixed for the stream
+    std::string GetFillKey(uint64_t seed, uint32_t stream) const
+    {
+        std::ostringstream ss;
+        ss << GetDataType<Tgpu>() << ' ' << desc.GetLayout_t() << ' ' << desc << ' ' << seed
+           << ' ' << stream;
+        return ss.str();
+    }
+
+    // Takes over the data of an earlier tensor with the same fill key
+    bool TakeFilledData(const std::string& key)
+    {
+        if(!is_input || !FilledDataCache<Tgpu>::Instance().Take(key, cpuData))
+            return false;
+        fill_key = key;
+        return true;
+    }
+
+    // Hands the filled data over to the FilledDataCache
+    void RetainFilledData()
+    {
+        if(!fill_key.empty() && !cpuData.empty())
+            FilledDataCache<Tgpu>::Instance().Put(fill_key, std::move(cpuData));
+        cpuData.clear();
+        fill_key.clear();
+    }
+
+    // Strided view of a host buffer of this tensor in N, C, D, H, W order,
+    // 2D tensors get a depth of one
+    template <typename T>
+    CpuTensorView<T> MakeCpuView(T* data) const
+    {
+        const auto& lens    = desc.GetLengths();
+        const auto& strides = desc.GetStrides();
+        if(lens.size() != 4 && lens.size() != 5)
+            throw std::runtime_error("Only 2D and 3D tensors have a CPU view");
+        CpuTensorView<T> view;
+        view.data = data;
+        view.lens.fill(1);
+        for(size_t dim = 0; dim < lens.size(); dim++)
+        {
+            const size_t view_dim = dim < 2 ? dim : dim + 5 - lens.size();
+            view.lens[view_dim]    = lens[dim];
+            view.strides[view_dim] = strides[dim];
+        }
+        return view;
+    }
+
+    private:
+    template <typename F>
+    void FillLogical(const CounterRng& rng, F f, Tgpu* dst, size_t num_threads)
+    {
+        constexpr size_t block_size = 1024;
+        constexpr size_t min_chunk  = 64 * block_size;
+        ParallelFor(
+            GetTensorSize(),
+            num_threads,
+            [&](size_t begin, size_t end) {
+                std::array<float, block_size> block;
+                for(size_t first = begin; first < end; first += block_size)
+                {
+                    const auto count = std::min(block_size, end - first);
+                    rng.FillUniform(first, count, block.data());
+                    for(size_t i = 0; i < count; i++)
+                        block[i] = f(block[i], first + i);
+                    ConvertFromFloat(block.data(), dst + first, count);
+                }
+            },
+            min_chunk);
+    }
 };
 } // namespace fin
 #endif // GUARD_FIN_TENSOR_HPP
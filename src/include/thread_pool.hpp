@@ -0,0 +1,161 @@
+/*******************************************************************************
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ *all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+#ifndef GUARD_FIN_THREAD_POOL_HPP
+#define GUARD_FIN_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fin {
+
+// Fixed size pool of worker threads. Tasks are executed in submission order
+// and their results (or exceptions) are returned through std::future.
+class ThreadPool
+{
+    public:
+    explicit ThreadPool(size_t num_threads)
+    {
+        num_threads = std::max<size_t>(num_threads, 1);
+        workers.reserve(num_threads);
+        for(size_t idx = 0; idx < num_threads; idx++)
+            workers.emplace_back([this]() { WorkerLoop(); });
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for(auto& worker : workers)
+            worker.join();
+    }
+
+    template <typename F>
+    auto Submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R   = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto res  = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.emplace_back([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return res;
+    }
+
+    size_t Size() const { return workers.size(); }
+
+    private:
+    void WorkerLoop()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]() { return stop || !tasks.empty(); });
+                if(tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stop = false;
+};
+
+// Split [0, n) into at most num_threads contiguous ranges of at least
+// min_chunk elements and call f(begin, end) for each of them concurrently.
+// The calling thread processes the first range. Exceptions thrown by f are
+// rethrown after all ranges have finished.
+template <typename F>
+void ParallelFor(size_t n, size_t num_threads, F&& f, size_t min_chunk = 1)
+{
+    min_chunk              = std::max<size_t>(min_chunk, 1);
+    const size_t max_parts = (n + min_chunk - 1) / min_chunk;
+    const size_t parts     = std::max<size_t>(std::min(num_threads, max_parts), 1);
+    const size_t chunk     = (n + parts - 1) / parts;
+    if(parts <= 1)
+    {
+        if(n != 0)
+            f(size_t{0}, n);
+        return;
+    }
+
+    std::vector<std::future<void>> rest;
+    rest.reserve(parts - 1);
+    for(size_t begin = chunk; begin < n; begin += chunk)
+    {
+        const size_t end = std::min(begin + chunk, n);
+        rest.push_back(std::async(std::launch::async, [&f, begin, end]() { f(begin, end); }));
+    }
+    std::exception_ptr error;
+    try
+    {
+        f(size_t{0}, std::min(chunk, n));
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+    }
+    for(auto& part : rest)
+    {
+        try
+        {
+            part.get();
+        }
+        catch(...)
+        {
+            if(!error)
+                error = std::current_exception();
+        }
+    }
+    if(error)
+        std::rethrow_exception(error);
+}
+
+} // namespace fin
+#endif // GUARD_FIN_THREAD_POOL_HPP
@@ -30,6 +30,9 @@
 #include "bn_fin.hpp"
 #include "error.hpp"
 #include "fin.hpp"
+#include "json_reader.hpp"
+#include "json_writer.hpp"
+#include "thread_pool.hpp"
 
 #if HIP_PACKAGE_VERSION_FLAT >= 5006000000ULL
 #include <half/half.hpp>
@@ -47,6 +50,8 @@ typedef half float16;
 
 #include <algorithm>
 #include <cstdio>
+#include <deque>
+#include <future>
 #include <iostream>
 
 using json = nlohmann::json;
@@ -58,14 +63,116 @@ using json = nlohmann::json;
     printf("Supported arguments:\n");
     printf("-i *input_json\n");
     printf("-o *output_json\n");
+    printf("--ndjson        write one result per line instead of a json array\n");
+    printf("--stream-input  parse and run one job at a time instead of loading the whole "
+           "input\n");
+    printf("--jobs *N       run up to N jobs concurrently, only supported with the NOGPU "
+           "backend\n");
+    printf("--threads *N    number of worker threads a job may use, defaults to 1\n");
+    printf("--host-device   allocate the device buffers in host memory, to run the buffer "
+           "handling without a GPU, only supported with the NOGPU backend\n");
+    printf("--device-cache *MB  keep up to MB of released device buffers for later jobs, "
+           "defaults to 0\n");
+    printf("--host-cache *MB    keep up to MB of released host buffers for later jobs, "
+           "defaults to 0\n");
+    printf("--filled-cache *MB  keep up to MB of filled inputs per data type for later jobs "
+           "that set \"reuse_filled_data\", defaults to 0\n");
     printf("\n");
     exit(0);
 }
 
+// The value of a numeric argument, anything but a whole number is reported
+// like any other invalid argument
+int ParseIntArg(const std::string& arg, const std::string& value)
+{
+    try
+    {
+        size_t end       = 0;
+        const int parsed = std::stoi(value, &end);
+        if(end == value.size())
+            return parsed;
+    }
+    catch(const std::exception&)
+    {
+    }
+    std::cerr << "Invalid argument: " << arg << " " << value << std::endl;
+    Usage();
+}
+
+json RunJob(json& command)
+{
+    std::unique_ptr<fin::BaseFin> f = nullptr;
+    if(command.contains("config"))
+    {
+        if(command["config"]["cmd"] == "conv")
+        {
+            f = std::make_unique<fin::ConvFin<float, float>>(command);
+        }
+        else if(command["config"]["cmd"] == "convfp16")
+        {
+            f = std::make_unique<fin::ConvFin<float16, float>>(command);
+        }
+        else if(command["config"]["cmd"] == "convbfp16")
+        {
+            f = std::make_unique<fin::ConvFin<bfloat16, float>>(command);
+        }
+        else if(command["config"]["cmd"] == "convint8")
+        {
+            f = std::make_unique<fin::ConvFin<int8_t, float>>(command);
+        }
+        else if(command["config"]["cmd"] == "bnorm")
+        {
+            f = std::make_unique<fin::BNFin<float, float>>(command);
+        }
+        else if(command["config"]["cmd"] == "bnormfp16")
+        {
+            f = std::make_unique<fin::BNFin<float16, float>>(command);
+        }
+        else
+        {
+            FIN_THROW("Invalid operation: " + command["config"]["cmd"].get<std::string>());
+            exit(-1);
+        }
+    }
+    else
+    {
+        f = std::make_unique<fin::ConvFin<float, float>>(command);
+    }
+
+    for(auto& step_it : command["steps"])
+    {
+        if(step_it == "get_solvers")
+        {
+            f->GetSolverList();
+        }
+        else
+        {
+            std::string step = step_it.get<std::string>();
+            f->ProcessStep(step);
+        }
+    }
+    f->output["config_tuna_id"] = command["config_tuna_id"];
+    f->output["arch"]           = command["arch"];
+    f->output["direction"]      = command["direction"];
+    // the kernels of the input are only referenced by md5 in the output
+    if(command.value("kernel_refs_only", false))
+        fin::BaseFin::StripKernelBlobs(command);
+    // the job is done, hand its input over instead of copying it
+    f->output["input"] = std::move(command);
+    return std::move(f->output);
+}
+
 int main(int argc, char* argv[], char* envp[])
 {
     std::vector<std::string> args(argv, argv + argc);
     std::map<char, std::string> MapInputs = {};
+    bool ndjson                           = false;
+    bool stream_input                     = false;
+    size_t num_jobs                       = 1;
+    size_t num_threads                    = 1;
+    // caches of buffers across jobs, in MB, all off unless asked for
+    std::map<std::string, size_t> cache_mb = {
+        {"--device-cache", 0}, {"--host-cache", 0}, {"--filled-cache", 0}};
 
     for(auto& arg : args)
     {
@@ -75,29 +182,84 @@ int main(int argc, char* argv[], char* envp[])
         }
     }
 
-    if(argc != 5)
+    for(int i = 1; i < args.size(); i++)
     {
-        std::cerr << "Invalid arguments" << std::endl;
-        Usage();
-    }
-
-    for(int i = 0; i < args.size(); i++)
-    {
-        if(args[i] == "-i")
+        if(args[i] == "-i" || args[i] == "-o")
         {
-            if(!boost::filesystem::exists(args[i + 1]))
+            if(i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for argument: " << args[i] << std::endl;
+                Usage();
+            }
+            if(args[i] == "-i" && !boost::filesystem::exists(args[i + 1]))
             {
                 std::cerr << "File: " << args[i + 1] << " does not exist" << std::endl;
                 exit(-1);
             }
             MapInputs[args[i].back()] = args[i + 1];
+            i++;
         }
-        if(args[i] == "-o")
+        else if(args[i] == "--ndjson")
         {
-            MapInputs[args[i].back()] = args[i + 1];
+            ndjson = true;
+        }
+        else if(args[i] == "--stream-input")
+        {
+            stream_input = true;
+        }
+        else if(args[i] == "--host-device")
+        {
+#if MIOPEN_MODE_NOGPU
+            // must be set before any buffer is allocated
+            fin::DeviceAllocator() = std::make_shared<fin::HostAllocator>();
+#else
+            std::cerr << "--host-device requires the NOGPU backend" << std::endl;
+            exit(-1);
+#endif
+        }
+        else if(args[i] == "--jobs")
+        {
+            if(i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for argument: " << args[i] << std::endl;
+                Usage();
+            }
+            num_jobs = std::max(ParseIntArg(args[i], args[i + 1]), 1);
+            i++;
+        }
+        else if(args[i] == "--threads")
+        {
+            if(i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for argument: " << args[i] << std::endl;
+                Usage();
+            }
+            num_threads = std::max(ParseIntArg(args[i], args[i + 1]), 1);
+            i++;
+        }
+        else if(cache_mb.count(args[i]) != 0)
+        {
+            if(i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for argument: " << args[i] << std::endl;
+                Usage();
+            }
+            cache_mb[args[i]] = std::max(ParseIntArg(args[i], args[i + 1]), 0);
+            i++;
+        }
+        else
+        {
+            std::cerr << "Invalid argument: " << args[i] << std::endl;
+            Usage();
         }
     }
 
+    if(MapInputs.count('i') == 0 || MapInputs.count('o') == 0)
+    {
+        std::cerr << "Invalid arguments" << std::endl;
+        Usage();
+    }
+
     boost::filesystem::path input_filename(MapInputs['i']);
     boost::filesystem::path output_filename(MapInputs['o']);
 
@@ -109,17 +271,16 @@ int main(int argc, char* argv[], char* envp[])
 
         throw std::runtime_error("Error loading json file: " + input_filename.string());
     }
-    // TODO: fix the output writing so that interim results are not lost if one of
-    // the iterations crash
     std::ofstream output_file(output_filename.string());
     if(!output_file)
     {
         throw std::runtime_error("Error opening json file: " + output_filename.string());
     }
-    json j; //  = json::parse(cmd);
-    input_file >> j;
-    input_file.close();
-    json final_output;
+    // MIOpen binaries and tuning results stay within this run
+    fin::ScopedUserCache user_cache;
+    // Results are written as soon as a job is done, so that interim results
+    // are not lost if one of the iterations crash
+    fin::JsonStreamWriter writer(output_file, ndjson);
     // Get the process env
     std::vector<std::string> jenv;
     for(auto env = envp; *env != nullptr; env++)
@@ -127,69 +288,66 @@ int main(int argc, char* argv[], char* envp[])
     json res_item;
 
     res_item["process_env"] = jenv;
-    final_output.push_back(res_item);
-    // process through the jobs
-    for(auto& it : j)
+    writer.Write(res_item);
+#if !MIOPEN_MODE_NOGPU
+    if(num_jobs > 1)
     {
-        auto command                    = it;
-        std::unique_ptr<fin::BaseFin> f = nullptr;
-        if(command.contains("config"))
-        {
-            if(command["config"]["cmd"] == "conv")
-            {
-                f = std::make_unique<fin::ConvFin<float, float>>(command);
-            }
-            else if(command["config"]["cmd"] == "convfp16")
-            {
-                f = std::make_unique<fin::ConvFin<float16, float>>(command);
-            }
-            else if(command["config"]["cmd"] == "convbfp16")
-            {
-                f = std::make_unique<fin::ConvFin<bfloat16, float>>(command);
-            }
-            else if(command["config"]["cmd"] == "convint8")
-            {
-                f = std::make_unique<fin::ConvFin<int8_t, float>>(command);
-            }
-            else if(command["config"]["cmd"] == "bnorm")
-            {
-                f = std::make_unique<fin::BNFin<float, float>>(command);
-            }
-            else if(command["config"]["cmd"] == "bnormfp16")
-            {
-                f = std::make_unique<fin::BNFin<float16, float>>(command);
-            }
-            else
-            {
-                FIN_THROW("Invalid operation: " + command["config"]["cmd"].get<std::string>());
-                exit(-1);
-            }
-        }
-        else
+        // GPU steps share the device, run them one after another
+        std::cerr << "Concurrent jobs require the NOGPU backend, running jobs serially"
+                  << std::endl;
+        num_jobs = 1;
+    }
+#endif
+    fin::BaseFin::DefaultNumThreads() = num_threads;
+    fin::FilledDataMaxBytes()         = cache_mb["--filled-cache"] << 20;
+    fin::DeviceArena()->SetMaxCached(cache_mb["--device-cache"] << 20);
+    fin::HostArena()->SetMaxCached(cache_mb["--host-cache"] << 20);
+    std::unique_ptr<fin::ThreadPool> pool = nullptr;
+    std::deque<std::future<json>> pending;
+    if(num_jobs > 1)
+        pool = std::make_unique<fin::ThreadPool>(num_jobs);
+    // Jobs are queued on the pool and the results are written in input
+    // order, only a bounded number of jobs is kept in flight
+    const auto process_job = [&](json& command) {
+        if(!pool)
         {
-            f = std::make_unique<fin::ConvFin<float, float>>(command);
+            writer.Write(RunJob(command));
+            return;
         }
-
-        for(auto& step_it : command["steps"])
+        pending.push_back(
+            pool->Submit([job = std::move(command)]() mutable { return RunJob(job); }));
+        while(pending.size() >= 2 * num_jobs)
         {
-            if(step_it == "get_solvers")
-            {
-                f->GetSolverList();
-            }
-            else
-            {
-                std::string step = step_it.get<std::string>();
-                f->ProcessStep(step);
-            }
+            writer.Write(pending.front().get());
+            pending.pop_front();
         }
-        f->output["config_tuna_id"] = command["config_tuna_id"];
-        f->output["arch"]           = command["arch"];
-        f->output["direction"]      = command["direction"];
-        f->output["input"]          = command;
-        final_output.push_back(f->output);
+    };
+    // process through the jobs
+    if(stream_input)
+    {
+        // eval inputs carry every compiled kernel, parse only one job at a time
+        fin::ForEachJob(input_file, process_job);
+    }
+    else
+    {
+        json j; //  = json::parse(cmd);
+        input_file >> j;
+        for(auto& it : j)
+            process_job(it);
     }
-    output_file << std::setw(4) << final_output << std::endl;
-    output_file.flush();
+    while(!pending.empty())
+    {
+        writer.Write(pending.front().get());
+        pending.pop_front();
+    }
+    // Device memory is freed while the runtime is still up, not by static
+    // destructors at exit. Joining the job threads releases their workspaces,
+    // the device buffers the arena keeps go last.
+    pool.reset();
+    fin::BaseFin::DeviceWorkspace().Release();
+    fin::DeviceArena()->SetMaxCached(0);
+    input_file.close();
+    writer.Close();
     output_file.close();
     return 0;
 }
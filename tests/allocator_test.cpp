@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <config.h>
+#include <allocator.hpp>
+#include <gpu_mem.hpp>
+
+// Host allocator that can be limited to a maximum allocation size
+class LimitedHostAllocator : public fin::HostAllocator
+{
+    public:
+    explicit LimitedHostAllocator(size_t _limit) : limit(_limit) {}
+    void* Allocate(size_t bytes) override
+    {
+        if(bytes > limit)
+            throw std::bad_alloc();
+        live++;
+        return fin::HostAllocator::Allocate(bytes);
+    }
+    void Free(void* ptr) override
+    {
+        live--;
+        fin::HostAllocator::Free(ptr);
+    }
+    size_t limit;
+    int live = 0;
+};
+
+TEST(AllocatorTest, WorkspaceGrowsGeometrically)
+{
+    auto allocator = std::make_shared<LimitedHostAllocator>(1 << 30);
+    fin::WorkspacePool pool(allocator);
+    EXPECT_EQ(pool.Reserve(0), nullptr);
+    EXPECT_EQ(pool.NumAllocations(), 0u);
+
+    for(size_t bytes = 1000; bytes <= 64000; bytes += 1000)
+    {
+        auto ptr = pool.Reserve(bytes);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_GE(pool.Size(), bytes);
+        // the buffer is usable up to its full size
+        std::memset(ptr, 0xff, pool.Size());
+    }
+    // 1000, 2000, 4000, ..., 64000
+    EXPECT_EQ(pool.NumAllocations(), 7u);
+    EXPECT_EQ(allocator->live, 1);
+}
+
+TEST(AllocatorTest, WorkspaceIsReused)
+{
+    auto allocator = std::make_shared<LimitedHostAllocator>(1 << 30);
+    fin::WorkspacePool pool(allocator);
+    auto ptr = pool.Reserve(4096);
+    EXPECT_EQ(pool.Reserve(100), ptr);
+    EXPECT_EQ(pool.Reserve(4096), ptr);
+    EXPECT_EQ(pool.NumAllocations(), 1u);
+    pool.Release();
+    EXPECT_EQ(pool.Size(), 0u);
+    EXPECT_EQ(allocator->live, 0);
+}
+
+TEST(AllocatorTest, WorkspaceFallsBackToExactSize)
+{
+    auto allocator = std::make_shared<LimitedHostAllocator>(3000);
+    fin::WorkspacePool pool(allocator);
+    pool.Reserve(2000);
+    // doubling would need 4000 bytes, which is over the limit
+    EXPECT_NE(pool.Reserve(2500), nullptr);
+    EXPECT_EQ(pool.Size(), 2500u);
+    EXPECT_THROW(pool.Reserve(5000), std::bad_alloc);
+    EXPECT_EQ(allocator->live, 0);
+}
+
+TEST(AllocatorTest, HostDeviceBuffers)
+{
+    // run the device buffers on the host for this test only
+    auto device_allocator   = fin::DeviceAllocator();
+    fin::DeviceAllocator()  = std::make_shared<fin::HostAllocator>();
+    std::vector<float> data = {1.0f, 2.0f, 3.0f, 4.0f};
+    std::vector<float> result(data.size(), 0.0f);
+    {
+        fin::GPUMem mem{0, data.size(), sizeof(float)};
+        EXPECT_EQ(mem.GetSize(), data.size() * sizeof(float));
+        EXPECT_EQ(mem.ToGPU(nullptr, data.data()), 0);
+        EXPECT_EQ(mem.FromGPU(nullptr, result.data()), 0);
+        EXPECT_EQ(result, data);
+        EXPECT_EQ(mem.Zero(nullptr), 0);
+        EXPECT_EQ(mem.FromGPU(nullptr, result.data()), 0);
+    }
+    fin::DeviceAllocator() = device_allocator;
+    EXPECT_EQ(result, std::vector<float>(data.size(), 0.0f));
+}
+
+TEST(AllocatorTest, ArenaReusesBuffersOfTheSameSize)
+{
+    auto allocator = std::make_shared<LimitedHostAllocator>(1 << 30);
+    {
+        fin::BufferArena arena(allocator, 10000);
+        auto a = arena.Acquire(4000);
+        auto b = arena.Acquire(2000);
+        arena.Release(a, 4000);
+        arena.Release(b, 2000);
+        EXPECT_EQ(arena.CachedBytes(), 6000u);
+        EXPECT_EQ(arena.Acquire(4000), a);
+        EXPECT_EQ(arena.Acquire(2000), b);
+        EXPECT_EQ(arena.NumAllocations(), 2u);
+
+        // over the cap the buffer released first is freed
+        auto c = arena.Acquire(8000);
+        arena.Release(a, 4000);
+        arena.Release(b, 2000);
+        arena.Release(c, 8000);
+        EXPECT_EQ(arena.CachedBytes(), 10000u);
+        EXPECT_EQ(allocator->live, 2);
+    }
+    EXPECT_EQ(allocator->live, 0);
+}
+
+TEST(AllocatorTest, HostBuffersComeFromTheArena)
+{
+    const auto arena = fin::HostArena();
+    // nothing is kept unless the cap is raised
+    EXPECT_EQ(arena->MaxCached(), 0u);
+    arena->SetMaxCached(1 << 20);
+    const auto allocations = arena->NumAllocations();
+    const float* data      = nullptr;
+    {
+        std::vector<float, fin::HostArenaAllocator<float>> v(1000, 1.0f);
+        data = v.data();
+    }
+    std::vector<float, fin::HostArenaAllocator<float>> v(1000);
+    EXPECT_EQ(v.data(), data);
+    EXPECT_EQ(arena->NumAllocations(), allocations + 1);
+    arena->SetMaxCached(0);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <benchmark.hpp>
+
+using json = nlohmann::json;
+
+// Replays a fixed sequence of timings, repeating the last one
+struct SyntheticTimer
+{
+    std::vector<float> times;
+    size_t calls = 0;
+    float operator()()
+    {
+        const auto t = times[std::min(calls, times.size() - 1)];
+        calls++;
+        return t;
+    }
+};
+
+TEST(BenchmarkTest, FixedIterations)
+{
+    fin::BenchmarkConfig config;
+    SyntheticTimer timer{{100.0f, 4.0f, 1.0f, 3.0f, 2.0f}};
+    const auto stats = fin::RunBenchmark(config, std::ref(timer));
+    // one warmup run plus four timed runs
+    EXPECT_EQ(timer.calls, 5u);
+    EXPECT_EQ(stats.iterations, 4u);
+    EXPECT_FLOAT_EQ(stats.min, 1.0f);
+    EXPECT_FLOAT_EQ(stats.median, 2.0f);
+    EXPECT_FLOAT_EQ(stats.mean, 2.5f);
+    EXPECT_FLOAT_EQ(stats.p90, 4.0f);
+}
+
+TEST(BenchmarkTest, AdaptiveStopsWhenStable)
+{
+    const auto config = fin::BenchmarkConfig::FromJson(json{{"adaptive", true}});
+    SyntheticTimer timer{{50.0f, 10.0f}};
+    const auto stats = fin::RunBenchmark(config, std::ref(timer));
+    EXPECT_EQ(stats.iterations, config.min_iters);
+    EXPECT_FLOAT_EQ(stats.stddev, 0.0f);
+}
+
+TEST(BenchmarkTest, AdaptiveRunsLongerWhenNoisy)
+{
+    auto config = fin::BenchmarkConfig::FromJson(
+        json{{"adaptive", true}, {"min_iters", 5}, {"max_iters", 40}, {"target_cv", 0.05}});
+    std::vector<float> times{1.0f};
+    // noisy at first, then settles down
+    for(int idx = 0; idx < 10; idx++)
+        times.push_back(idx % 2 ? 20.0f : 5.0f);
+    times.push_back(10.0f);
+    SyntheticTimer timer{times};
+    const auto stats = fin::RunBenchmark(config, std::ref(timer));
+    EXPECT_GT(stats.iterations, config.min_iters);
+    EXPECT_LE(stats.iterations, config.max_iters);
+}
+
+TEST(BenchmarkTest, AdaptiveHonorsMaxIters)
+{
+    auto config = fin::BenchmarkConfig::FromJson(
+        json{{"adaptive", true}, {"warmup", 0}, {"min_iters", 3}, {"max_iters", 8}});
+    SyntheticTimer timer;
+    for(int idx = 0; idx < 20; idx++)
+        timer.times.push_back(idx % 2 ? 1.0f : 9.0f);
+    const auto stats = fin::RunBenchmark(config, std::ref(timer));
+    EXPECT_EQ(timer.calls, 8u);
+    EXPECT_EQ(stats.iterations, 8u);
+}
+
+TEST(BenchmarkTest, ConfidenceIntervalCriterion)
+{
+    fin::BenchmarkConfig config;
+    config.adaptive  = true;
+    config.target_ci = 0.05;
+    auto stats       = fin::ComputeBenchmarkStats({9.0f, 10.0f, 11.0f});
+    // cv is 0.1, the 95% interval of the mean is about +-11%
+    EXPECT_FALSE(fin::IsBenchmarkStable(stats, config));
+    stats = fin::ComputeBenchmarkStats(std::vector<float>(30, 10.0f));
+    EXPECT_TRUE(fin::IsBenchmarkStable(stats, config));
+}
+
+// Host side stand-in for an invoker and its params
+struct HostInvokeParams
+{
+    std::vector<float> data;
+};
+
+struct CountingTimer
+{
+    size_t starts = 0;
+    size_t laps   = 0;
+    void Start() { starts++; }
+    void Lap() { laps++; }
+    float Stop() const { return 8.0f; }
+};
+
+TEST(BenchmarkTest, BatchedInvocations)
+{
+    auto config = fin::BenchmarkConfig::FromJson(json{{"batch", 4}});
+    HostInvokeParams params{std::vector<float>(1024, 1.0f)};
+    size_t invocations = 0;
+    float sum          = 0;
+    const auto invoke  = [&](const HostInvokeParams& p) {
+        invocations++;
+        sum = std::accumulate(p.data.begin(), p.data.end(), 0.0f);
+    };
+    CountingTimer timer;
+    const auto stats = fin::BenchmarkInvocations(config, invoke, params, timer);
+    // a warmup batch and four timed batches
+    EXPECT_EQ(timer.starts, 5u);
+    EXPECT_EQ(timer.laps, 20u);
+    EXPECT_EQ(invocations, 20u);
+    EXPECT_FLOAT_EQ(sum, 1024.0f);
+    // the time of a batch is spread over its invocations
+    EXPECT_FLOAT_EQ(stats.median, 2.0f);
+}
+
+TEST(BenchmarkTest, InvalidTimer)
+{
+    EXPECT_THROW(fin::BenchmarkConfig::FromJson(json{{"timer", "wall"}}), std::runtime_error);
+}
+
+TEST(BenchmarkTest, HostTimer)
+{
+    auto config = fin::BenchmarkConfig::FromJson(
+        json{{"timer", "host"}, {"min_iters", 2}, {"max_iters", 2}});
+    EXPECT_EQ(config.timer, "host");
+    const auto invoke = [](int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+    fin::HostTimer timer;
+    const auto stats = fin::BenchmarkInvocations(config, invoke, 2, timer);
+    EXPECT_EQ(stats.iterations, 2u);
+    EXPECT_GE(stats.min, 2.0f);
+}
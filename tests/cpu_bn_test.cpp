@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <cpu_bn.hpp>
+#include <random.hpp>
+
+#include <vector>
+
+namespace {
+
+struct Buffer
+{
+    std::vector<double> data;
+    fin::CpuTensorView<double> view;
+
+    Buffer(const std::array<size_t, 5>& lens, uint32_t stream, double lo = -1.0, double hi = 1.0)
+    {
+        view.lens    = lens;
+        view.strides = fin::PackedStrides(lens);
+        data.resize(view.ElementSize());
+        view.data = data.data();
+        const fin::CounterRng rng{0, stream};
+        for(size_t i = 0; i < data.size(); i++)
+            data[i] = rng.Range<double>(i, lo, hi);
+    }
+};
+
+std::array<size_t, 5> ParamLens(fin::CpuBnMode mode, const std::array<size_t, 5>& lens)
+{
+    if(mode == fin::CpuBnMode::Spatial)
+        return {1, lens[1], 1, 1, 1};
+    return {1, lens[1], lens[2], lens[3], lens[4]};
+}
+
+const fin::CpuTensorView<double> none{};
+
+} // namespace
+
+TEST(CpuBnTest, WelfordMergeMatchesTwoPass)
+{
+    const std::vector<double> values = {1e6 + 1, 1e6 + 4, 1e6 + 2, 1e6 + 8, 1e6 + 3, 1e6 + 7};
+    fin::WelfordStats a;
+    fin::WelfordStats b;
+    for(size_t i = 0; i < values.size(); i++)
+        (i < 2 ? a : b).Add(values[i]);
+    a.Merge(b);
+
+    double mean = 0.0;
+    for(auto v : values)
+        mean += v;
+    mean /= values.size();
+    double var = 0.0;
+    for(auto v : values)
+        var += (v - mean) * (v - mean);
+    var /= values.size();
+    EXPECT_NEAR(a.mean, mean, 1e-9);
+    EXPECT_NEAR(a.Variance(), var, 1e-9);
+}
+
+TEST(CpuBnTest, TrainNormalizesAndUpdatesRunningStats)
+{
+    for(auto mode : {fin::CpuBnMode::Spatial, fin::CpuBnMode::PerActivation})
+    {
+        const std::array<size_t, 5> lens{4, 3, 2, 5, 6};
+        Buffer x{lens, 0, 2.0, 5.0};
+        Buffer scale{ParamLens(mode, lens), 1};
+        Buffer bias{ParamLens(mode, lens), 2};
+        Buffer y{lens, 3};
+        Buffer run_mean{ParamLens(mode, lens), 4};
+        Buffer run_var{ParamLens(mode, lens), 5, 0.5, 1.0};
+        Buffer mean{ParamLens(mode, lens), 6};
+        Buffer inv_var{ParamLens(mode, lens), 7};
+        const auto old_mean = run_mean.data;
+        const auto old_var  = run_var.data;
+        const double eps    = 1e-5;
+        const double factor = 0.1;
+        fin::BnFwdTrainCpu(mode,
+                           eps,
+                           factor,
+                           x.view,
+                           scale.view,
+                           bias.view,
+                           y.view,
+                           run_mean.view,
+                           run_var.view,
+                           mean.view,
+                           inv_var.view,
+                           3);
+
+        // normalized output has the bias as mean and |scale| as deviation
+        const size_t count = x.data.size() / mean.data.size();
+        std::vector<fin::WelfordStats> x_stats(mean.data.size());
+        std::vector<fin::WelfordStats> y_stats(mean.data.size());
+        for(size_t n = 0; n < lens[0]; n++)
+            for(size_t c = 0; c < lens[1]; c++)
+                for(size_t i = 0; i < lens[2] * lens[3] * lens[4]; i++)
+                {
+                    const size_t slot =
+                        mode == fin::CpuBnMode::Spatial ? c : c * lens[2] * lens[3] * lens[4] + i;
+                    const size_t idx = (n * lens[1] + c) * lens[2] * lens[3] * lens[4] + i;
+                    x_stats[slot].Add(x.data[idx]);
+                    y_stats[slot].Add(y.data[idx]);
+                }
+        for(size_t slot = 0; slot < mean.data.size(); slot++)
+        {
+            const double var = x_stats[slot].Variance();
+            EXPECT_NEAR(mean.data[slot], x_stats[slot].mean, 1e-12);
+            EXPECT_NEAR(inv_var.data[slot], 1.0 / std::sqrt(var + eps), 1e-9);
+            EXPECT_NEAR(y_stats[slot].mean, bias.data[slot], 1e-9);
+            EXPECT_NEAR(std::sqrt(y_stats[slot].Variance()),
+                        std::abs(scale.data[slot]) * std::sqrt(var / (var + eps)),
+                        1e-9);
+            EXPECT_NEAR(run_mean.data[slot],
+                        (1 - factor) * old_mean[slot] + factor * x_stats[slot].mean,
+                        1e-12);
+            EXPECT_NEAR(run_var.data[slot],
+                        (1 - factor) * old_var[slot] + factor * var * count / (count - 1),
+                        1e-12);
+        }
+
+        // inference with the batch statistics reproduces the training output
+        Buffer var{ParamLens(mode, lens), 8};
+        for(size_t slot = 0; slot < var.data.size(); slot++)
+            var.data[slot] = x_stats[slot].Variance();
+        Buffer y_infer{lens, 9};
+        fin::BnFwdInferCpu(
+            mode, eps, x.view, scale.view, bias.view, mean.view, var.view, y_infer.view, 2);
+        for(size_t i = 0; i < y.data.size(); i++)
+            ASSERT_NEAR(y_infer.data[i], y.data[i], 1e-9);
+    }
+}
+
+// The backward pass is the gradient of sum(dy * y) with respect to x, scale
+// and bias, checked against central differences of the training forward
+TEST(CpuBnTest, BackwardMatchesNumericalGradient)
+{
+    for(auto mode : {fin::CpuBnMode::Spatial, fin::CpuBnMode::PerActivation})
+    {
+        const std::array<size_t, 5> lens{3, 2, 1, 3, 2};
+        Buffer x{lens, 0};
+        Buffer dy{lens, 1};
+        Buffer scale{ParamLens(mode, lens), 2};
+        Buffer bias{ParamLens(mode, lens), 3};
+        Buffer dx{lens, 4};
+        Buffer dscale{ParamLens(mode, lens), 5};
+        Buffer dbias{ParamLens(mode, lens), 6};
+        const double eps = 1e-3;
+        fin::BnBwdCpu(mode,
+                      eps,
+                      x.view,
+                      dy.view,
+                      scale.view,
+                      none,
+                      none,
+                      dx.view,
+                      dscale.view,
+                      dbias.view,
+                      1);
+
+        const auto loss = [&]() {
+            Buffer y{lens, 7};
+            fin::BnFwdTrainCpu(
+                mode, eps, 0.0, x.view, scale.view, bias.view, y.view, none, none, none, none, 1);
+            double sum = 0.0;
+            for(size_t i = 0; i < y.data.size(); i++)
+                sum += dy.data[i] * y.data[i];
+            return sum;
+        };
+        const auto numeric = [&](double& v) {
+            const double h    = 1e-6;
+            const double orig = v;
+            v                 = orig + h;
+            const double up   = loss();
+            v                 = orig - h;
+            const double down = loss();
+            v                 = orig;
+            return (up - down) / (2 * h);
+        };
+        for(size_t i = 0; i < x.data.size(); i++)
+            EXPECT_NEAR(dx.data[i], numeric(x.data[i]), 1e-6) << i;
+        for(size_t i = 0; i < scale.data.size(); i++)
+        {
+            EXPECT_NEAR(dscale.data[i], numeric(scale.data[i]), 1e-6) << i;
+            EXPECT_NEAR(dbias.data[i], numeric(bias.data[i]), 1e-6) << i;
+        }
+    }
+}
+
+TEST(CpuBnTest, RejectsMismatchedParameters)
+{
+    const std::array<size_t, 5> lens{2, 3, 1, 4, 4};
+    Buffer x{lens, 0};
+    Buffer y{lens, 1};
+    Buffer scale{ParamLens(fin::CpuBnMode::PerActivation, lens), 2};
+    EXPECT_THROW(fin::BnFwdInferCpu(fin::CpuBnMode::Spatial,
+                                    1e-5,
+                                    x.view,
+                                    scale.view,
+                                    scale.view,
+                                    scale.view,
+                                    scale.view,
+                                    y.view,
+                                    1),
+                 std::runtime_error);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <cpu_conv.hpp>
+#include <random.hpp>
+
+#include <vector>
+
+namespace {
+
+struct Shape
+{
+    size_t n, groups, c_per_g, k_per_g;
+    std::array<size_t, 3> in;
+    std::array<size_t, 3> fil;
+    fin::CpuConvProblem problem;
+
+    std::array<size_t, 5> XLens() const
+    {
+        return {n, groups * c_per_g, in[0], in[1], in[2]};
+    }
+    std::array<size_t, 5> WLens() const
+    {
+        return {groups * k_per_g, c_per_g, fil[0], fil[1], fil[2]};
+    }
+    std::array<size_t, 5> YLens() const
+    {
+        std::array<size_t, 5> lens{n, groups * k_per_g, 0, 0, 0};
+        for(size_t dim = 0; dim < 3; dim++)
+        {
+            const auto span = problem.dilations[dim] * (fil[dim] - 1) + 1;
+            lens[2 + dim] = (in[dim] + 2 * problem.pads[dim] - span) / problem.strides[dim] + 1;
+        }
+        return lens;
+    }
+};
+
+struct Buffer
+{
+    std::vector<double> data;
+    fin::CpuTensorView<double> view;
+
+    Buffer(const std::array<size_t, 5>& lens, uint32_t stream)
+    {
+        view.lens    = lens;
+        view.strides = fin::PackedStrides(lens);
+        data.resize(view.ElementSize());
+        view.data = data.data();
+        const fin::CounterRng rng{0, stream};
+        for(size_t i = 0; i < data.size(); i++)
+            data[i] = rng.Range<double>(i, -1.0, 1.0);
+    }
+};
+
+double Dot(const Buffer& a, const Buffer& b)
+{
+    double sum = 0.0;
+    for(size_t i = 0; i < a.data.size(); i++)
+        sum += a.data[i] * b.data[i];
+    return sum;
+}
+
+// Straightforward definition of the grouped convolution
+void NaiveFwd(const Shape& s, const Buffer& x, const Buffer& w, Buffer& y)
+{
+    const auto yl = s.YLens();
+    const auto& p = s.problem;
+    // input position along dim, negative or past the end in the padding
+    const auto pos = [&](size_t dim, size_t o, size_t f) {
+        return static_cast<long long>(o) * p.strides[dim] - p.pads[dim] +
+               static_cast<long long>(f) * p.dilations[dim];
+    };
+    const auto inside = [&](size_t dim, long long i) {
+        return i >= 0 && i < static_cast<long long>(s.in[dim]);
+    };
+    for(size_t n = 0; n < yl[0]; n++)
+        for(size_t k = 0; k < yl[1]; k++)
+            for(size_t oz = 0; oz < yl[2]; oz++)
+                for(size_t oy = 0; oy < yl[3]; oy++)
+                    for(size_t ox = 0; ox < yl[4]; ox++)
+                    {
+                        double sum    = 0.0;
+                        const auto xc = (k / s.k_per_g) * s.c_per_g;
+                        for(size_t c = 0; c < s.c_per_g; c++)
+                            for(size_t fz = 0; fz < s.fil[0]; fz++)
+                                for(size_t fy = 0; fy < s.fil[1]; fy++)
+                                    for(size_t fx = 0; fx < s.fil[2]; fx++)
+                                    {
+                                        const auto iz = pos(0, oz, fz);
+                                        const auto iy = pos(1, oy, fy);
+                                        const auto ix = pos(2, ox, fx);
+                                        if(inside(0, iz) && inside(1, iy) && inside(2, ix))
+                                            sum += x.view(n, xc + c, iz, iy, ix) *
+                                                   w.view(k, c, fz, fy, fx);
+                                    }
+                        y.view(n, k, oz, oy, ox) = sum;
+                    }
+}
+
+const std::vector<Shape>& TestShapes()
+{
+    static const std::vector<Shape> shapes = {
+        // 2D, padded, strided and dilated
+        {2, 1, 3, 4, {1, 9, 11}, {1, 3, 3}, {1, {0, 1, 2}, {1, 2, 1}, {1, 1, 2}}},
+        // 2D grouped with a 1x1 filter
+        {1, 4, 2, 3, {1, 5, 6}, {1, 1, 1}, {4, {0, 0, 0}, {1, 1, 1}, {1, 1, 1}}},
+        // 3D grouped, padded and strided
+        {2, 2, 2, 2, {5, 6, 7}, {3, 2, 3}, {2, {1, 0, 1}, {2, 1, 2}, {1, 2, 1}}},
+    };
+    return shapes;
+}
+
+} // namespace
+
+TEST(CpuConvTest, ForwardMatchesNaive)
+{
+    for(const auto& s : TestShapes())
+    {
+        Buffer x{s.XLens(), 0};
+        Buffer w{s.WLens(), 1};
+        Buffer ref{s.YLens(), 2};
+        Buffer y{s.YLens(), 3};
+        NaiveFwd(s, x, w, ref);
+        fin::ConvFwdCpu(s.problem, x.view, w.view, y.view, 3);
+        for(size_t i = 0; i < y.data.size(); i++)
+            ASSERT_NEAR(y.data[i], ref.data[i], 1e-12) << i;
+    }
+}
+
+TEST(CpuConvTest, ForwardWithNhwcInput)
+{
+    const auto& s = TestShapes()[0];
+    Buffer x{s.XLens(), 0};
+    Buffer w{s.WLens(), 1};
+    Buffer ref{s.YLens(), 2};
+    fin::ConvFwdCpu(s.problem, x.view, w.view, ref.view, 1);
+
+    // same values stored channels last
+    const auto& l = x.view.lens;
+    std::vector<float> nhwc(x.data.size());
+    const fin::CpuTensorView<float> x_nhwc{
+        nhwc.data(), l, {l[1] * l[2] * l[3] * l[4], 1, l[1] * l[3] * l[4], l[1] * l[4], l[1]}};
+    for(size_t n = 0; n < l[0]; n++)
+        for(size_t c = 0; c < l[1]; c++)
+            for(size_t h = 0; h < l[3]; h++)
+                for(size_t v = 0; v < l[4]; v++)
+                    x_nhwc(n, c, 0, h, v) = static_cast<float>(x.view(n, c, 0, h, v));
+
+    Buffer y{s.YLens(), 3};
+    fin::ConvFwdCpu(s.problem, x_nhwc, w.view, y.view, 2);
+    const auto stats = fin::CompareToReference(y.view, ref.view);
+    EXPECT_LT(stats.rms, 1e-6);
+    EXPECT_EQ(stats.num_nans, 0u);
+}
+
+// <y, fwd(x, w)> == <bwd_data(y, w), x> == <bwd_weights(x, y), w>
+TEST(CpuConvTest, BackwardPassesAreAdjoint)
+{
+    for(const auto& s : TestShapes())
+    {
+        Buffer x{s.XLens(), 0};
+        Buffer w{s.WLens(), 1};
+        Buffer dy{s.YLens(), 2};
+        Buffer y{s.YLens(), 3};
+        Buffer dx{s.XLens(), 4};
+        Buffer dw{s.WLens(), 5};
+        fin::ConvFwdCpu(s.problem, x.view, w.view, y.view, 2);
+        fin::ConvBwdDataCpu(s.problem, dy.view, w.view, dx.view, 2);
+        fin::ConvWrwCpu(s.problem, x.view, dy.view, dw.view, 2);
+        const double ref = Dot(dy, y);
+        EXPECT_NEAR(Dot(dx, x), ref, 1e-9 * (1.0 + std::abs(ref)));
+        EXPECT_NEAR(Dot(dw, w), ref, 1e-9 * (1.0 + std::abs(ref)));
+    }
+}
+
+TEST(CpuConvTest, IndependentOfThreadCount)
+{
+    const auto& s = TestShapes()[2];
+    Buffer x{s.XLens(), 0};
+    Buffer dy{s.YLens(), 1};
+    Buffer dw1{s.WLens(), 2};
+    Buffer dw8{s.WLens(), 3};
+    fin::ConvWrwCpu(s.problem, x.view, dy.view, dw1.view, 1);
+    fin::ConvWrwCpu(s.problem, x.view, dy.view, dw8.view, 8);
+    EXPECT_EQ(dw1.data, dw8.data);
+}
+
+TEST(CpuConvTest, RmsError)
+{
+    Buffer ref{{1, 1, 1, 2, 2}, 0};
+    ref.data = {1.0, -2.0, 0.5, 4.0};
+    std::vector<float> out = {1.0f, -2.0f, 0.5f, 3.0f};
+    const fin::CpuTensorView<float> view{out.data(), ref.view.lens, ref.view.strides};
+    const auto stats = fin::CompareToReference(view, ref.view);
+    EXPECT_DOUBLE_EQ(stats.max_abs_error, 1.0);
+    EXPECT_DOUBLE_EQ(stats.rms, 1.0 / (2.0 * 4.0));
+}
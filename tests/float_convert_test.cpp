@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <float_convert.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+float FromBits(uint32_t bits)
+{
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+} // namespace
+
+TEST(FloatConvertTest, HalfRoundsToNearestEven)
+{
+    using fin::detail::FloatToHalfBits;
+    EXPECT_EQ(FloatToHalfBits(0.0f), 0x0000);
+    EXPECT_EQ(FloatToHalfBits(-0.0f), 0x8000);
+    EXPECT_EQ(FloatToHalfBits(1.0f), 0x3c00);
+    EXPECT_EQ(FloatToHalfBits(-2.0f), 0xc000);
+    EXPECT_EQ(FloatToHalfBits(65504.0f), 0x7bff);
+    EXPECT_EQ(FloatToHalfBits(65520.0f), 0x7c00);
+    EXPECT_EQ(FloatToHalfBits(std::numeric_limits<float>::infinity()), 0x7c00);
+    EXPECT_EQ(FloatToHalfBits(std::ldexp(1.0f, -24)), 0x0001);
+    EXPECT_EQ(FloatToHalfBits(std::ldexp(1.0f, -25)), 0x0000);
+    EXPECT_EQ(FloatToHalfBits(std::ldexp(1.0f, -14)), 0x0400);
+    // halfway between 1 and the next half goes to the even mantissa
+    EXPECT_EQ(FloatToHalfBits(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    EXPECT_EQ(FloatToHalfBits(1.0f + 3 * std::ldexp(1.0f, -11)), 0x3c02);
+    EXPECT_EQ(FloatToHalfBits(std::numeric_limits<float>::quiet_NaN()) & 0x7e00, 0x7e00);
+}
+
+TEST(FloatConvertTest, BFloat16RoundsToNearestEven)
+{
+    using fin::detail::FloatToBFloat16Bits;
+    EXPECT_EQ(FloatToBFloat16Bits(1.0f), 0x3f80);
+    EXPECT_EQ(FloatToBFloat16Bits(-1.0f), 0xbf80);
+    EXPECT_EQ(FloatToBFloat16Bits(FromBits(0x3f808000)), 0x3f80);
+    EXPECT_EQ(FloatToBFloat16Bits(FromBits(0x3f818000)), 0x3f82);
+    EXPECT_EQ(FloatToBFloat16Bits(FromBits(0x3f808001)), 0x3f81);
+    EXPECT_EQ(FloatToBFloat16Bits(std::numeric_limits<float>::infinity()), 0x7f80);
+    EXPECT_EQ(FloatToBFloat16Bits(FromBits(0x7f800001)) & 0x7fc0, 0x7fc0);
+}
+
+TEST(FloatConvertTest, BulkMatchesScalar)
+{
+    // Bit patterns spread over the whole float range, including the half
+    // denormal and overflow ranges and lengths that are not a multiple of
+    // the vector width
+    std::vector<float> src;
+    for(uint64_t bits = 0; bits <= 0xffffffffULL; bits += 0x10001)
+    {
+        const float f = FromBits(static_cast<uint32_t>(bits));
+        if(!std::isnan(f))
+            src.push_back(f);
+    }
+    src.resize(src.size() - 3);
+
+    std::vector<uint16_t> half(src.size());
+    std::vector<uint16_t> bf16(src.size());
+    fin::ConvertFloatsToHalfBits(src.data(), half.data(), src.size());
+    fin::ConvertFloatsToBFloat16Bits(src.data(), bf16.data(), src.size());
+    for(size_t i = 0; i < src.size(); i++)
+    {
+        ASSERT_EQ(half[i], fin::detail::FloatToHalfBits(src[i])) << src[i];
+        ASSERT_EQ(bf16[i], fin::detail::FloatToBFloat16Bits(src[i])) << src[i];
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <kernel_dedup.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+fin::json MakeKernel(const std::string& md5_sum, size_t blob_size)
+{
+    fin::json kernel;
+    kernel["md5_sum"]           = md5_sum;
+    kernel["uncompressed_size"] = 2 * blob_size;
+    kernel["blob"]              = std::string(blob_size, 'x');
+    return kernel;
+}
+} // namespace
+
+TEST(KernelDedupTest, PackagesEveryKernelOnce)
+{
+    fin::KernelDedup dedup;
+    int made        = 0;
+    const auto make = [&]() {
+        made++;
+        return MakeKernel("a", 10);
+    };
+    EXPECT_EQ(dedup.Get(fin::KernelKey("k.s", "-O3  -g", "gfx90a"), make)["md5_sum"], "a");
+    const auto kernel = dedup.Get(fin::KernelKey("k.s", " -O3 -g", "gfx90a"), make);
+    EXPECT_EQ(kernel["blob"].get<std::string>().size(), 10u);
+    EXPECT_EQ(made, 1);
+    EXPECT_TRUE(dedup.Contains(fin::KernelKey("k.s", "-O3 -g", "gfx90a")));
+    EXPECT_FALSE(dedup.Contains(fin::KernelKey("k.s", "-O3 -g", "gfx908")));
+}
+
+TEST(KernelDedupTest, DropsLeastRecentlyUsedBlobs)
+{
+    fin::KernelDedup dedup{250};
+    int made        = 0;
+    const auto make = [&]() {
+        made++;
+        return MakeKernel(std::to_string(made), 100);
+    };
+    dedup.Get("a", make);
+    dedup.Get("b", make);
+    // a is used again, so b is the one dropped for c
+    dedup.Get("a", make);
+    dedup.Get("c", make);
+    EXPECT_EQ(made, 3);
+    EXPECT_EQ(dedup.Size(), 2u);
+    EXPECT_EQ(dedup.Bytes(), 200u);
+    EXPECT_TRUE(dedup.Contains("a"));
+    EXPECT_FALSE(dedup.Contains("b"));
+    // a dropped kernel is packaged again
+    EXPECT_EQ(dedup.Get("b", make)["md5_sum"], "4");
+    EXPECT_EQ(dedup.Size(), 2u);
+}
+
+TEST(KernelDedupTest, FailuresAreRetried)
+{
+    fin::KernelDedup dedup;
+    EXPECT_THROW(dedup.Get("a", []() -> fin::json { throw std::runtime_error("no"); }),
+                 std::runtime_error);
+    EXPECT_FALSE(dedup.Contains("a"));
+    EXPECT_EQ(dedup.Get("a", []() { return MakeKernel("a", 1); })["md5_sum"], "a");
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <fstream>
+
+#include <kernel_loader.hpp>
+
+using json = nlohmann::json;
+
+static json LoadPerfEvalJob()
+{
+    std::string input_filename = TEST_RESOURCE_DIR "../src/tests/fin_input_perf_eval.json";
+    std::ifstream input_file(input_filename);
+    if(!input_file)
+    {
+        EXPECT_FALSE(true) << "ERROR: cannot open test file " << input_filename << std::endl;
+    }
+    json j;
+    input_file >> j;
+    return j[0];
+}
+
+TEST(KernelLoaderTest, DecodeFixtureBlobs)
+{
+    const auto job     = LoadPerfEvalJob();
+    const auto& result = job["miopen_perf_compile_result"];
+    ASSERT_FALSE(result.empty());
+    for(const auto& kernel_obj : result[0]["kernel_objects"])
+    {
+        const auto kernel = fin::DecodeKernelObject(kernel_obj, job);
+        EXPECT_TRUE(kernel.valid) << kernel.kernel_file;
+        EXPECT_EQ(kernel.hsaco.size(), kernel_obj["uncompressed_size"].get<size_t>());
+        EXPECT_EQ(kernel.kernel_file, kernel_obj["kernel_file"].get<std::string>());
+    }
+}
+
+TEST(KernelLoaderTest, CompileResultListsPerfCfgs)
+{
+    const auto job = LoadPerfEvalJob();
+    auto result    = job["miopen_perf_compile_result"][0];
+    // results are only timed by perf config when the compile recorded them
+    EXPECT_TRUE(fin::GetCompiledPerfCfgs(result).empty());
+    const std::vector<std::string> params = {"16,64,8,2,2,2,4,4,4,4,8,2,16,1,4,64",
+                                             "16,64,8,2,2,2,4,4,4,4,8,2,16,1,4,32"};
+    result["params"]                      = params;
+    EXPECT_EQ(fin::GetCompiledPerfCfgs(result), params);
+    result["params"] = params[0];
+    EXPECT_EQ(fin::GetCompiledPerfCfgs(result), std::vector<std::string>{params[0]});
+}
+
+TEST(KernelLoaderTest, PrefetchMatchesSerialDecode)
+{
+    const auto job     = LoadPerfEvalJob();
+    const auto& result = job["miopen_perf_compile_result"];
+    fin::KernelPrefetcher prefetcher(result, job, 4);
+    for(size_t idx = 0; idx < result.size(); idx++)
+    {
+        const auto kernels      = prefetcher.Get(idx);
+        const auto& kernel_objs = result[idx]["kernel_objects"];
+        ASSERT_EQ(kernels.size(), kernel_objs.size());
+        for(size_t k = 0; k < kernels.size(); k++)
+        {
+            const auto serial = fin::DecodeKernelObject(kernel_objs[k], job);
+            EXPECT_TRUE(kernels[k].valid);
+            EXPECT_EQ(kernels[k].comp_options, serial.comp_options);
+            EXPECT_EQ(kernels[k].hsaco, serial.hsaco);
+        }
+    }
+}
+
+TEST(KernelLoaderTest, CorruptBlobIsNotValid)
+{
+    auto job        = LoadPerfEvalJob();
+    auto kernel_obj = job["miopen_perf_compile_result"][0]["kernel_objects"][0];
+    kernel_obj["md5_sum"] = "00000000000000000000000000000000";
+    EXPECT_FALSE(fin::DecodeKernelObject(kernel_obj, job).valid);
+}
+
+TEST(KernelLoaderTest, PrefetchSkipsFilteredResults)
+{
+    const auto job = LoadPerfEvalJob();
+    json results   = json::array();
+    for(size_t idx = 0; idx < 4; idx++)
+        results.push_back(job["miopen_perf_compile_result"][0]);
+    size_t filtered = 0;
+    fin::KernelPrefetcher prefetcher(results, job, 2, 0, [&](const json&) {
+        filtered++;
+        return false;
+    });
+    // the last result is asked for directly, the ones before it are dropped
+    const auto kernels = prefetcher.Get(3);
+    EXPECT_EQ(kernels.size(), results[3]["kernel_objects"].size());
+    for(const auto& kernel : kernels)
+        EXPECT_TRUE(kernel.valid);
+    EXPECT_EQ(filtered, 3u);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <layout_transform.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// N x C x S test tensor with odd sizes, so that no dim is a multiple of
+// the tile or vector lengths
+constexpr size_t N = 3;
+constexpr size_t C = 13;
+constexpr size_t S = 7 * 11;
+
+template <typename T>
+std::vector<T> Iota(size_t size)
+{
+    std::vector<T> data(size);
+    for(size_t i = 0; i < size; i++)
+        data[i] = static_cast<T>(i % 127 + 1);
+    return data;
+}
+
+size_t Nchw(size_t n, size_t c, size_t s) { return (n * C + c) * S + s; }
+
+} // namespace
+
+TEST(LayoutTransformTest, NhwcRoundTrip)
+{
+    const auto src = Iota<float>(N * C * S);
+    std::vector<float> nhwc(src.size());
+    std::vector<float> back(src.size());
+    fin::NchwToNhwc(src.data(), nhwc.data(), N, C, S, 2);
+    for(size_t n = 0; n < N; n++)
+        for(size_t c = 0; c < C; c++)
+            for(size_t s = 0; s < S; s++)
+                ASSERT_EQ(nhwc[(n * S + s) * C + c], src[Nchw(n, c, s)]);
+    fin::NhwcToNchw(nhwc.data(), back.data(), N, C, S, 3);
+    EXPECT_EQ(back, src);
+}
+
+TEST(LayoutTransformTest, Chwn)
+{
+    const auto src = Iota<uint16_t>(N * C * S);
+    std::vector<uint16_t> chwn(src.size());
+    fin::NchwToChwn(src.data(), chwn.data(), N, C, S, 4);
+    for(size_t n = 0; n < N; n++)
+        for(size_t c = 0; c < C; c++)
+            for(size_t s = 0; s < S; s++)
+                ASSERT_EQ(chwn[(c * S + s) * N + n], src[Nchw(n, c, s)]);
+}
+
+TEST(LayoutTransformTest, VectorizedRoundTrip)
+{
+    const auto src = Iota<int8_t>(N * C * S);
+    for(size_t vec : {4, 8})
+    {
+        const size_t blocks = fin::PaddedChannels(C, vec) / vec;
+        std::vector<int8_t> nchwc(N * blocks * S * vec, -1);
+        std::vector<int8_t> chwnc(nchwc.size(), -1);
+        fin::NchwToNchwVect(src.data(), nchwc.data(), N, C, S, vec, 3);
+        fin::NchwToChwnVect(src.data(), chwnc.data(), N, C, S, vec, 2);
+        for(size_t n = 0; n < N; n++)
+            for(size_t c = 0; c < blocks * vec; c++)
+                for(size_t s = 0; s < S; s++)
+                {
+                    const int8_t expected = c < C ? src[Nchw(n, c, s)] : 0;
+                    const size_t cb       = c / vec;
+                    const size_t lane     = c % vec;
+                    ASSERT_EQ(nchwc[((n * blocks + cb) * S + s) * vec + lane], expected);
+                    ASSERT_EQ(chwnc[((cb * S + s) * N + n) * vec + lane], expected);
+                }
+
+        std::vector<int8_t> back(src.size());
+        fin::NchwVectToNchw(nchwc.data(), back.data(), N, C, S, vec, 2);
+        EXPECT_EQ(back, src);
+        std::fill(back.begin(), back.end(), 0);
+        fin::ChwnVectToNchw(chwnc.data(), back.data(), N, C, S, vec, 3);
+        EXPECT_EQ(back, src);
+    }
+}
+
+TEST(LayoutTransformTest, PadChannels)
+{
+    const auto src     = Iota<int8_t>(N * C * S);
+    const size_t c_pad  = fin::PaddedChannels(C, 4);
+    std::vector<int8_t> dst(N * c_pad * S, -1);
+    fin::PadChannels(src.data(), dst.data(), N, C, c_pad, S, 2);
+    for(size_t n = 0; n < N; n++)
+        for(size_t c = 0; c < c_pad; c++)
+            for(size_t s = 0; s < S; s++)
+                ASSERT_EQ(dst[(n * c_pad + c) * S + s], c < C ? src[Nchw(n, c, s)] : 0);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <random.hpp>
+#include <thread_pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(RandomTest, PhiloxKnownAnswers)
+{
+    // Known answer vectors from the Random123 distribution
+    using Ctr = fin::Philox4x32::counter_type;
+    EXPECT_EQ(fin::Philox4x32::Generate({0, 0, 0, 0}, {0, 0}),
+              (Ctr{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(fin::Philox4x32::Generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                        {0xffffffff, 0xffffffff}),
+              (Ctr{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(fin::Philox4x32::Generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                        {0xa4093822, 0x299f31d0}),
+              (Ctr{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(RandomTest, StreamsAreIndependent)
+{
+    const fin::CounterRng a{0, 0};
+    const fin::CounterRng b{0, 1};
+    const fin::CounterRng c{1, 0};
+    size_t same_stream = 0;
+    size_t same_seed   = 0;
+    for(uint64_t idx = 0; idx < 64; idx++)
+    {
+        const float u = a.Uniform(idx);
+        EXPECT_GE(u, 0.0f);
+        EXPECT_LT(u, 1.0f);
+        EXPECT_EQ(u, fin::CounterRng(0, 0).Uniform(idx));
+        same_stream += (a.Bits(idx) == b.Bits(idx)) ? 1 : 0;
+        same_seed += (a.Bits(idx) == c.Bits(idx)) ? 1 : 0;
+    }
+    EXPECT_EQ(same_stream, 0u);
+    EXPECT_EQ(same_seed, 0u);
+}
+
+TEST(RandomTest, BlockFillMatchesElementwise)
+{
+    const fin::CounterRng rng{7, 2};
+    std::vector<float> block(37);
+    rng.FillUniform(5, block.size(), block.data());
+    for(size_t i = 0; i < block.size(); i++)
+        EXPECT_EQ(block[i], rng.Uniform(5 + i));
+}
+
+TEST(RandomTest, ParallelFillIndependentOfThreads)
+{
+    const size_t n = 100003;
+    const fin::CounterRng rng{42, 3};
+    const auto fill = [&](size_t num_threads) {
+        std::vector<float> data(n);
+        fin::ParallelFor(
+            n,
+            num_threads,
+            [&](size_t begin, size_t end) {
+                for(size_t i = begin; i < end; i++)
+                    data[i] = rng.Range<float>(i, -0.5f, 0.5f);
+            },
+            1000);
+        return data;
+    };
+    const auto ref = fill(1);
+    EXPECT_EQ(fill(3), ref);
+    EXPECT_EQ(fill(8), ref);
+}
+
+TEST(RandomTest, ParallelForCoversRangeAndRethrows)
+{
+    std::vector<std::atomic<int>> hits(1000);
+    fin::ParallelFor(hits.size(), 7, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++)
+            hits[i]++;
+    });
+    for(const auto& hit : hits)
+        EXPECT_EQ(hit.load(), 1);
+
+    EXPECT_THROW(fin::ParallelFor(100,
+                                  4,
+                                  [](size_t begin, size_t) {
+                                      if(begin != 0)
+                                          throw std::runtime_error("failed");
+                                  }),
+                 std::runtime_error);
+}